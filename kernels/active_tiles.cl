@@ -0,0 +1,70 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+constant sampler_t sampler_point = CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST | CLK_NORMALIZED_COORDS_FALSE;
+
+// one work-group per CFD tile, mask entry set if any texel of the tile
+// carries density or velocity above threshold
+kernel void tile_activity( float threshold, read_only image2d_t flds,
+                           global uchar * mask )
+{
+    local int active;
+
+    int2 uv = (int2)((int)get_global_id(0), (int)get_global_id(1));
+
+    if (get_local_id(0) == 0 && get_local_id(1) == 0)
+        active = 0;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    float3 field = read_imagef(flds, sampler_point, uv).xyz;
+    if (max(field.z, length(field.xy)) > threshold)
+        atomic_or(&active, 1);
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (get_local_id(0) == 0 && get_local_id(1) == 0)
+        mask[get_group_id(1) * get_num_groups(0) + get_group_id(0)] = (uchar)active;
+}
+
+// one work-item per CFD tile, dilates the activity mask by one tile so the
+// solver stencils never read stale texels, keeps tiles active one frame after
+// they became quiet to flush their content and appends them to the list
+kernel void compact_tiles( int2 tiles, global const uchar * mask,
+                           global const uchar * prev, global uchar * dilated,
+                           global int2 * list, volatile global int * count )
+{
+    int2 t = (int2)((int)get_global_id(0), (int)get_global_id(1));
+
+    uchar active = 0;
+    for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++)
+        {
+            int2 n = (t + (int2)(x, y) + tiles) % tiles;
+            active |= mask[n.y * tiles.x + n.x];
+        }
+
+    int id = t.y * tiles.x + t.x;
+    dilated[id] = active;
+
+    if (active || prev[id])
+        list[atomic_inc(count)] = t;
+}
@@ -21,6 +21,7 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
+#include "cfd_tiles.h"
 constant sampler_t sampler_repeat = CLK_ADDRESS_REPEAT | CLK_FILTER_LINEAR | CLK_NORMALIZED_COORDS_TRUE;
 float2 px2tx(float2 fuv, float4 info)
 {
@@ -31,9 +32,11 @@ float2 px2tx(float2 fuv, float4 info)
 // info.z - dt
 // info.w - dumping factor
 kernel void advect( float4 info, read_only image2d_t vels,
-                          read_only image2d_t field, write_only image2d_t dst )
+                          read_only image2d_t field, write_only image2d_t dst CFD_TILE_ARGS CFD_DT_ARGS )
 {
-    int2 uv = (int2)((int)get_global_id(0), (int)get_global_id(1));
+    CFD_TILE_ORIGIN(org);
+    CFD_DT(info);
+    int2 uv = org + (int2)((int)get_local_id(0), (int)get_local_id(1));
     float2 pxc = convert_float2(uv) + (float2)(0.5f);
 
     float dt = info.z*info.w;
@@ -43,3 +46,43 @@ kernel void advect( float4 info, read_only image2d_t vels,
     float4 val = read_imagef(field, sampler_repeat, px2tx(pos, info));
     write_imagef(dst, uv, val);
 }
+
+constant sampler_t sampler_texel = CLK_ADDRESS_REPEAT | CLK_FILTER_NEAREST | CLK_NORMALIZED_COORDS_TRUE;
+
+// MacCormack correction of semi-Lagrangian result, fwd holds the field
+// advected by advect kernel, error is estimated with reversed trace and
+// result is limited to the range of texels sampled by forward trace
+// info.x - simulation width
+// info.y - simulation height
+// info.z - dt
+// info.w - dumping factor
+kernel void maccormack( float4 info, read_only image2d_t vels,
+                        read_only image2d_t field, read_only image2d_t fwd,
+                        write_only image2d_t dst CFD_TILE_ARGS CFD_DT_ARGS )
+{
+    CFD_TILE_ORIGIN(org);
+    CFD_DT(info);
+    int2 uv = org + (int2)((int)get_local_id(0), (int)get_local_id(1));
+    float2 pxc = convert_float2(uv) + (float2)(0.5f);
+
+    float dt = info.z*info.w;
+    float2 vel = read_imagef(vels, sampler_repeat, px2tx(pxc, info)).xy;
+
+    float4 val = read_imagef(fwd, sampler_repeat, px2tx(pxc, info));
+    float4 orig = read_imagef(field, sampler_repeat, px2tx(pxc, info));
+    float4 back = read_imagef(fwd, sampler_repeat, px2tx(pxc + (float2)(dt) * vel, info));
+
+    val += 0.5f * (orig - back);
+
+    // limiter, clamp to texels interpolated by backtrace
+    float2 pos = floor(pxc - (float2)(dt) * vel - (float2)(0.5f)) + (float2)(0.5f);
+    float4 t00 = read_imagef(field, sampler_texel, px2tx(pos, info));
+    float4 t10 = read_imagef(field, sampler_texel, px2tx(pos + (float2)(1.f, 0.f), info));
+    float4 t01 = read_imagef(field, sampler_texel, px2tx(pos + (float2)(0.f, 1.f), info));
+    float4 t11 = read_imagef(field, sampler_texel, px2tx(pos + (float2)(1.f, 1.f), info));
+
+    float4 vmin = fmin(fmin(t00, t10), fmin(t01, t11));
+    float4 vmax = fmax(fmax(t00, t10), fmax(t01, t11));
+
+    write_imagef(dst, uv, clamp(val, vmin, vmax));
+}
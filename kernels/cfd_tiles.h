@@ -0,0 +1,60 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef CFD_TILES_H
+#define CFD_TILES_H
+
+// Work-group origin of CFD stage kernels. With ACTIVE_TILES build option
+// groups are dispatched over the compacted list of active tiles and surplus
+// groups exit, otherwise the origin follows the regular NDRange.
+#ifdef ACTIVE_TILES
+#define CFD_TILE_ARGS , global const int2 * tiles, global const int * tile_count
+#define CFD_TILE_ORIGIN(org)                                                   \
+    int tile_id = (int)(get_group_id(1) * get_num_groups(0) + get_group_id(0));\
+    if (tile_id >= tile_count[0])                                              \
+        return;                                                                \
+    int2 org = tiles[tile_id] * (int2)((int)get_local_size(0), (int)get_local_size(1));
+#else
+#define CFD_TILE_ARGS
+#define CFD_TILE_ORIGIN(org)                                                   \
+    int2 org = (int2)((int)get_group_id(0), (int)get_group_id(1)) *            \
+               (int2)((int)get_local_size(0), (int)get_local_size(1));
+#endif
+
+// With DEVICE_DT build option the time step is read from a buffer filled by
+// the CFL reduction on device instead of the info argument.
+#ifdef DEVICE_DT
+#define CFD_DT_ARGS , global const float * dt_buf
+#define CFD_DT(info) info.z = dt_buf[0]
+#else
+#define CFD_DT_ARGS
+#define CFD_DT(info)
+#endif
+
+// periodic texel coordinates of tiles cached in local memory
+int2 wrap(int2 c, int2 size)
+{
+    return (c + size) % size;
+}
+
+#endif // CFD_TILES_H
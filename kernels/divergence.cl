@@ -33,12 +33,14 @@ SOFTWARE.
 // info.y - simulation height
 // info.z - dt
 // info.w - unused
+#include "cfd_tiles.h"
 constant sampler_t sampler_repeat = CLK_ADDRESS_REPEAT | CLK_FILTER_NEAREST | CLK_NORMALIZED_COORDS_FALSE;
 kernel void divergence( float4 info,
                         read_only image2d_t src,
-                        write_only image2d_t dst )
+                        write_only image2d_t dst CFD_TILE_ARGS )
 {
-    int2 uv = (int2)((int)get_global_id(0), (int)get_global_id(1));
+    CFD_TILE_ORIGIN(org);
+    int2 uv = org + (int2)((int)get_local_id(0), (int)get_local_id(1));
 
     float2 field01 = read_imagef(src, sampler_repeat, (uv + (int2)(-1, 0))).xy;
     float2 field21 = read_imagef(src, sampler_repeat, (uv + (int2)( 1, 0))).xy;
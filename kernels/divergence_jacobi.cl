@@ -0,0 +1,82 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Divergence computation fused with the first Jacobi relaxation sweep.
+// Velocity and pressure neighbourhoods are cached in local memory, group
+// size has to match TILE (passed as build option).
+
+// info.x - simulation width
+// info.y - simulation height
+// info.z - dt
+// info.w - unused
+#include "cfd_tiles.h"
+constant sampler_t sampler_point = CLK_ADDRESS_NONE | CLK_FILTER_NEAREST | CLK_NORMALIZED_COORDS_FALSE;
+
+kernel void divergence_jacobi( float4 info,
+                               read_only image2d_t vels,
+                               read_only image2d_t press_src,
+                               write_only image2d_t div_dst,
+                               write_only image2d_t press_dst CFD_TILE_ARGS )
+{
+    local float2 vtile[TILE + 2][TILE + 2];
+    local float ptile[TILE + 2][TILE + 2];
+
+    CFD_TILE_ORIGIN(org);
+
+    int2 size = (int2)((int)info.x, (int)info.y);
+    int2 lid = (int2)((int)get_local_id(0), (int)get_local_id(1));
+    int2 uv = org + lid;
+
+    // tile with one texel halo
+    for (int y = lid.y; y < TILE + 2; y += TILE)
+        for (int x = lid.x; x < TILE + 2; x += TILE)
+        {
+            int2 c = wrap(org + (int2)(x - 1, y - 1), size);
+            vtile[y][x] = read_imagef(vels, sampler_point, c).xy;
+            ptile[y][x] = read_imagef(press_src, sampler_point, c).x;
+        }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int2 t = lid + (int2)(1);
+
+    float2 field01 = vtile[t.y][t.x - 1];
+    float2 field21 = vtile[t.y][t.x + 1];
+    float2 field10 = vtile[t.y - 1][t.x];
+    float2 field12 = vtile[t.y + 1][t.x];
+
+    float dc = 0.5f * (field21.x - field01.x + field12.y - field10.y);
+
+    float pl = ptile[t.y][t.x - 1];
+    float pb = ptile[t.y - 1][t.x];
+
+    float pr = ptile[t.y][t.x + 1];
+    float pt = ptile[t.y + 1][t.x];
+
+    const float alpha = 0.25f;
+    float pcd = alpha * (pl + pr + pb + pt - dc);
+
+    write_imagef(div_dst, uv, (float4)(dc, 0.f, 0.f, 0.f));
+    write_imagef(press_dst, uv, (float4)(pcd, 0.f, 0.f, 0.f));
+}
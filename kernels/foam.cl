@@ -28,9 +28,19 @@ constant sampler_t sampler_point = CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEARES
 // params.x - z min
 // params.y - z max
 // params.z - foam delimiter
+#ifdef ZRANGE_FROM_IMAGE
+// z range taken from the last level of reduction pyramid, params.xy unused
+#define ZRANGE_ARG , read_only image2d_t zrange
+#else
+#define ZRANGE_ARG
+#endif
 kernel void update_foam( int2 patch_info, float3 params, read_only image2d_t noise,
-                         read_only image2d_t displ, read_only image2d_t src, write_only image2d_t dst )
+                         read_only image2d_t displ, read_only image2d_t src, write_only image2d_t dst
+                         ZRANGE_ARG )
 {
+#ifdef ZRANGE_FROM_IMAGE
+    params.xy = read_imagef(zrange, sampler_point, (int2)(0, 0)).xy;
+#endif
     int2 uv = (int2)((int)get_global_id(0), (int)get_global_id(1));
     float2 fuv = convert_float2(uv) / patch_info.y;
 
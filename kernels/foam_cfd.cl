@@ -32,6 +32,8 @@ constant sampler_t sampler_point = CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEARES
 // params.s3 - wind x
 // params.s4 - wind y
 // params.s5 - dt
+// params.s6 - weight of visual foam update (0 - normal map foam untouched)
+// params.s7 - CFD grid multiplier
 kernel void update_foam( int2 patch_info, float8 params,
                          read_only image2d_t noise,
                          read_only image2d_t displ,
@@ -88,7 +90,7 @@ kernel void update_foam( int2 patch_info, float8 params,
     float dens_val = field.z;
 
     // Write to visual texture (using sharp mask)
-    write_imagef(dst_nmap, uv, (float4)(ndata.xyz, ndata.w + (dens_val - ndata.w) * 0.5f * params.s5  ));
+    write_imagef(dst_nmap, uv, (float4)(ndata.xyz, ndata.w + (dens_val - ndata.w) * 0.5f * params.s5 * params.s6 ));
 
     // Add new density (using sharp mask foam_fac_visual)
     float injected_density = max(foam_fac_visual, dens_val);
@@ -126,3 +128,24 @@ kernel void update_foam( int2 patch_info, float8 params,
     // Write to CFD fields: velocity updated smoothly, density (foam) updated sharply
     write_imagef(dst_flds, uv_cfd, (float4)(velocity, injected_density, 0.f));
 }
+
+// visual foam from density interpolated between the last two CFD steps,
+// used when CFD runs at its own fixed rate
+// params.x - interpolation factor between previous and current CFD step
+// params.y - dt
+// params.z - CFD grid multiplier
+kernel void blend_foam( float4 params,
+                        read_only image2d_t flds_prev,
+                        read_only image2d_t flds,
+                        read_only image2d_t src,
+                        write_only image2d_t dst_nmap )
+{
+    int2 uv = (int2)((int)get_global_id(0), (int)get_global_id(1));
+    int2 uv_cfd = uv * (int2)((int)params.z);
+
+    float4 ndata = read_imagef(src, sampler_point, uv);
+    float dens_prev = read_imagef(flds_prev, sampler_point, uv_cfd).z;
+    float dens_val = mix(dens_prev, read_imagef(flds, sampler_point, uv_cfd).z, params.x);
+
+    write_imagef(dst_nmap, uv, (float4)(ndata.xyz, ndata.w + (dens_val - ndata.w) * 0.5f * params.y));
+}
@@ -42,8 +42,9 @@ float4 gaussRND(float4 rnd)
 // params.y - wind.y
 // params.z - amplitude
 // params.w - capillar supress factor
+// band - wave number range kept by this cascade
 
-kernel void init_spectrum( int2 patch_info, float4 params, read_only image2d_t noise, write_only image2d_t dst )
+kernel void init_spectrum( int2 patch_info, float4 params, read_only image2d_t noise, write_only image2d_t dst, float2 band )
 {
     int2 uv = (int2)((int)get_global_id(0), (int)get_global_id(1));
 
@@ -69,7 +70,10 @@ kernel void init_spectrum( int2 patch_info, float4 params, read_only image2d_t n
     float h0kp = f0 * dp;
     float h0km = f0 * dm;
 
+    // waves outside of the band belong to other cascades
+    float in_band = (k_mag >= band.x && k_mag < band.y) ? 1.f : 0.f;
+
     float4 rnd = clamp(read_imagef(noise, sampler, uv), 0.001f, 1.f);
-    float4 gauss_random = gaussRND(rnd);
+    float4 gauss_random = gaussRND(rnd) * in_band;
     write_imagef(dst, uv, (float4)(gauss_random.xy*h0kp, gauss_random.zw*h0km));
 }
@@ -34,5 +34,6 @@ kernel void inversion( int2 patch_info, read_only image2d_t src0,
     float z = read_imagef(src2, sampler, uv).x;
 
     write_imagef(dst, uv, (float4)(x/res2, y/res2, z/res2, 1));
-    write_imagef(ranges, uv, (float4)(y/res2, y/res2, 0, 0));
+    // height range and largest horizontal displacement for reduction
+    write_imagef(ranges, uv, (float4)(y/res2, y/res2, fmax(fabs(x), fabs(z))/res2, 0));
 }
@@ -21,13 +21,15 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
+#include "cfd_tiles.h"
 constant sampler_t sampler_repeat = CLK_ADDRESS_REPEAT | CLK_FILTER_NEAREST | CLK_NORMALIZED_COORDS_FALSE;
 kernel void jacobi( float4 info,
                     read_only image2d_t div,
                     read_only image2d_t press_src,
-                    write_only image2d_t press_dst )
+                    write_only image2d_t press_dst CFD_TILE_ARGS )
 {
-    int2 uv = (int2)((int)get_global_id(0), (int)get_global_id(1));
+    CFD_TILE_ORIGIN(org);
+    int2 uv = org + (int2)((int)get_local_id(0), (int)get_local_id(1));
 
     float dc = read_imagef(div, sampler_repeat, uv).x;
 
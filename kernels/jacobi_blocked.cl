@@ -0,0 +1,87 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Temporally blocked Jacobi relaxation: STEPS sweeps per launch.
+// Tile is loaded with STEPS texels halo, every sweep shrinks the valid
+// region by one texel so the interior ends up identical to STEPS separate
+// launches of jacobi.cl. Group size has to match TILE, both TILE and STEPS
+// are passed as build options.
+
+// info.x - simulation width
+// info.y - simulation height
+// info.z - dt
+// info.w - unused
+#include "cfd_tiles.h"
+constant sampler_t sampler_point = CLK_ADDRESS_NONE | CLK_FILTER_NEAREST | CLK_NORMALIZED_COORDS_FALSE;
+
+#define EXT (TILE + 2 * STEPS)
+
+kernel void jacobi_blocked( float4 info,
+                            read_only image2d_t div,
+                            read_only image2d_t press_src,
+                            write_only image2d_t press_dst CFD_TILE_ARGS )
+{
+    local float ptile[2][EXT][EXT];
+    local float dtile[EXT][EXT];
+
+    CFD_TILE_ORIGIN(org);
+
+    int2 size = (int2)((int)info.x, (int)info.y);
+    int2 lid = (int2)((int)get_local_id(0), (int)get_local_id(1));
+    int2 uv = org + lid;
+
+    for (int y = lid.y; y < EXT; y += TILE)
+        for (int x = lid.x; x < EXT; x += TILE)
+        {
+            int2 c = wrap(org + (int2)(x - STEPS, y - STEPS), size);
+            ptile[0][y][x] = read_imagef(press_src, sampler_point, c).x;
+            dtile[y][x] = read_imagef(div, sampler_point, c).x;
+        }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    const float alpha = 0.25f;
+    for (int s = 1; s <= STEPS; s++)
+    {
+        int src = (s - 1) & 1;
+        int dst = s & 1;
+
+        for (int y = s + lid.y; y < EXT - s; y += TILE)
+            for (int x = s + lid.x; x < EXT - s; x += TILE)
+            {
+                float pl = ptile[src][y][x - 1];
+                float pb = ptile[src][y - 1][x];
+
+                float pr = ptile[src][y][x + 1];
+                float pt = ptile[src][y + 1][x];
+
+                ptile[dst][y][x] = alpha * (pl + pr + pb + pt - dtile[y][x]);
+            }
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    float pcd = ptile[STEPS & 1][lid.y + STEPS][lid.x + STEPS];
+    write_imagef(press_dst, uv, (float4)(pcd, 0.f, 0.f, 0.f));
+}
@@ -0,0 +1,104 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Last Jacobi relaxation sweep fused with the pressure gradient subtraction.
+// The sweep is evaluated over the tile extended by one texel, so the gradient
+// can be taken without another round trip through global memory. Group size
+// has to match TILE (passed as build option).
+
+// info.x - simulation width
+// info.y - simulation height
+// info.z - dt
+// info.w - unused
+#include "cfd_tiles.h"
+constant sampler_t sampler_point = CLK_ADDRESS_NONE | CLK_FILTER_NEAREST | CLK_NORMALIZED_COORDS_FALSE;
+
+kernel void jacobi_pressure( float4 info,
+                             read_only image2d_t div,
+                             read_only image2d_t press_src,
+                             read_only image2d_t vels_src,
+                             write_only image2d_t press_dst,
+                             write_only image2d_t vels_dst CFD_TILE_ARGS CFD_DT_ARGS )
+{
+    local float ptile[TILE + 4][TILE + 4];
+    local float dtile[TILE + 2][TILE + 2];
+    local float ntile[TILE + 2][TILE + 2];
+
+    CFD_TILE_ORIGIN(org);
+    CFD_DT(info);
+
+    int2 size = (int2)((int)info.x, (int)info.y);
+    int2 lid = (int2)((int)get_local_id(0), (int)get_local_id(1));
+    int2 uv = org + lid;
+
+    // previous pressure with two texels halo, divergence with one texel halo
+    for (int y = lid.y; y < TILE + 4; y += TILE)
+        for (int x = lid.x; x < TILE + 4; x += TILE)
+        {
+            int2 c = wrap(org + (int2)(x - 2, y - 2), size);
+            ptile[y][x] = read_imagef(press_src, sampler_point, c).x;
+        }
+
+    for (int y = lid.y; y < TILE + 2; y += TILE)
+        for (int x = lid.x; x < TILE + 2; x += TILE)
+        {
+            int2 c = wrap(org + (int2)(x - 1, y - 1), size);
+            dtile[y][x] = read_imagef(div, sampler_point, c).x;
+        }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // last relaxation sweep over the tile and its one texel halo
+    const float alpha = 0.25f;
+    for (int y = lid.y; y < TILE + 2; y += TILE)
+        for (int x = lid.x; x < TILE + 2; x += TILE)
+        {
+            float pl = ptile[y + 1][x];
+            float pb = ptile[y][x + 1];
+
+            float pr = ptile[y + 1][x + 2];
+            float pt = ptile[y + 2][x + 1];
+
+            ntile[y][x] = alpha * (pl + pr + pb + pt - dtile[y][x]);
+        }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int2 t = lid + (int2)(1);
+
+    float3 field = read_imagef(vels_src, sampler_point, uv).xyz;
+    float2 vc = field.xy;
+
+    float pl = ntile[t.y][t.x - 1];
+    float pb = ntile[t.y - 1][t.x];
+
+    float pr = ntile[t.y][t.x + 1];
+    float pt = ntile[t.y + 1][t.x];
+
+    float dt = info.z;
+    float2 grad = (float2)(dt * 0.5) * (float2)(pr - pl, pt - pb);
+
+    write_imagef(press_dst, uv, (float4)(ntile[t.y][t.x], 0.f, 0.f, 0.f));
+    write_imagef(vels_dst, uv, (float4)((vc.x-grad.x), (vc.y-grad.y), field.z, 0.f));
+}
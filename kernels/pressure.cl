@@ -21,13 +21,16 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
+#include "cfd_tiles.h"
 constant sampler_t sampler_repeat = CLK_ADDRESS_REPEAT | CLK_FILTER_NEAREST | CLK_NORMALIZED_COORDS_FALSE;
 kernel void pressure( float4 info,
                     read_only image2d_t press,
                     read_only image2d_t vels_src,
-                    write_only image2d_t vels_dst )
+                    write_only image2d_t vels_dst CFD_TILE_ARGS CFD_DT_ARGS )
 {
-    int2 uv = (int2)((int)get_global_id(0), (int)get_global_id(1));
+    CFD_TILE_ORIGIN(org);
+    CFD_DT(info);
+    int2 uv = org + (int2)((int)get_local_id(0), (int)get_local_id(1));
 
     float3 field = read_imagef(vels_src, sampler_repeat, uv).xyz;
     float2 vc = field.xy;
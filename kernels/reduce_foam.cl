@@ -36,3 +36,14 @@ kernel void reduce(
     float mxv = max(max(max(v0, v1), v2), v3);
     write_imagef(dst, uv, (float4)(mxv, 0, 0, 0));
 }
+
+// single work-item, CFL time step from reduced velocity magnitude kept on
+// device for solver kernels built with DEVICE_DT
+kernel void cfl_dt(
+    float dt_default,
+    read_only image2d_t vmax,
+    global float * dt)
+{
+    float v = read_imagef(vmax, sampler, (int2)(0, 0)).x;
+    dt[0] = (v > 1e-10f && !isnan(v)) ? 0.95f / v : dt_default;
+}
@@ -29,11 +29,12 @@ kernel void reduce_ranges(
     write_only image2d_t dst)
 {
     int2 uv = (int2)((int)get_global_id(0), (int)get_global_id(1));
-    float2 v0 = read_imagef(src, sampler, uv).xy;
-    float2 v1 = read_imagef(src, sampler, (int2)(uv.x + patch_info.x, uv.y)).xy;
-    float2 v2 = read_imagef(src, sampler, (int2)(uv.x, uv.y + patch_info.y)).xy;
-    float2 v3 = read_imagef(src, sampler, (int2)(uv.x + patch_info.x, uv.y + patch_info.y)).xy;
+    float4 v0 = read_imagef(src, sampler, uv);
+    float4 v1 = read_imagef(src, sampler, (int2)(uv.x + patch_info.x, uv.y));
+    float4 v2 = read_imagef(src, sampler, (int2)(uv.x, uv.y + patch_info.y));
+    float4 v3 = read_imagef(src, sampler, (int2)(uv.x + patch_info.x, uv.y + patch_info.y));
     float min_value = min(min(min(v0.x, v1.x), v2.x), v3.x);
     float max_value = max(max(max(v0.y, v1.y), v2.y), v3.y);
-    write_imagef(dst, uv, (float4)(min_value, max_value, 0, 0));
+    float max_xy = max(max(max(v0.z, v1.z), v2.z), v3.z);
+    write_imagef(dst, uv, (float4)(min_value, max_value, max_xy, 0));
 }
@@ -42,10 +42,20 @@ complex conj(complex c)
     return (complex)(c.x, -c.y);
 }
 
-kernel void spectrum( float dt, int2 patch_info,
+#ifdef TIME_FROM_BUFFER
+// elapsed time written by host before replay of recorded command buffer
+#define TIME_ARG global const float * time_buf
+#else
+#define TIME_ARG float dt
+#endif
+
+kernel void spectrum( TIME_ARG, int2 patch_info,
     read_only image2d_t src, write_only image2d_t dst_x,
     write_only image2d_t dst_y, write_only image2d_t dst_z )
 {
+#ifdef TIME_FROM_BUFFER
+    float dt = time_buf[0];
+#endif
     int2 uv = (int2)((int)get_global_id(0), (int)get_global_id(1));
     float2 wave_vec = convert_float2(uv) - (float2)((float)(patch_info.y-1)/2.f);
     float2 k = (2.f * PI * wave_vec) / patch_info.x;
@@ -28,7 +28,10 @@ layout(location = 1) in vec4 ec_pos;
 
 layout(location = 0) out vec4 out_color;
 
-layout(binding = 1) uniform sampler2D u_normal_map;
+// size of descriptor arrays, keep in sync with wave_util.hpp
+const int MAX_CASCADES = 4;
+
+layout(binding = 1) uniform sampler2D u_normal_map[MAX_CASCADES];
 layout(binding = 2) uniform ViewData {
     uniform mat4    view_mat;
     uniform mat4    proj_mat;
@@ -37,6 +40,10 @@ layout(binding = 2) uniform ViewData {
     uniform float   z_range_max;
     uniform float   choppiness;
     uniform float   alt_scale;
+    uniform vec4    cascade_scale;
+    uniform int     cascade_count;
+    uniform vec2    grid_offset;
+    uniform vec2    grid_tex_offset;
 } view;
 
 const vec3 env_specular = vec3(0.8);
@@ -77,11 +84,20 @@ mat3 get_linear_part( mat4 m )
 void main()
 {
     // normal map computed in opencl kernel
-    vec4 ndata = texture(u_normal_map, frag_tex_coord);
+    vec4 ndata = texture(u_normal_map[0], frag_tex_coord);
 
     // foam calculated in OpenCL code, could be improved with hi-res noise here
     float foam = ndata.w;
 
+    // cascades are combined through their slopes
+    vec2 slope = ndata.xy / ndata.z;
+    for (int i = 1; i < view.cascade_count; i++)
+    {
+        vec3 n = texture(u_normal_map[i], frag_tex_coord * view.cascade_scale[i]).xyz;
+        slope += n.xy / n.z;
+    }
+    ndata.xyz = normalize(vec3(slope, 1.0));
+
     // preparation of view space lighting computation
     mat3 norm_mat = get_linear_part(view.view_mat);
     vec3 normal = norm_mat * ndata.xyz;
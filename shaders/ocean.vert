@@ -26,10 +26,60 @@ SOFTWARE.
 layout(location = 0) out vec2 frag_tex_coord;
 layout(location = 1) out vec4 ec_pos;
 
+// size of descriptor arrays, keep in sync with wave_util.hpp
+const int MAX_CASCADES = 4;
+
+#ifdef VERTEX_PULLING
+// no vertex buffer, clipmap vertices follow from gl_VertexIndex with the
+// tile vertex layout of WaveVulkanLayer::createClipmapMesh
+layout(push_constant) uniform MeshData {
+    float   spacing;
+    float   inv_patch;
+    int     tile_cells;
+} mesh;
+
+// tile position and stitched edge of a ring level, hole tiles are skipped
+const ivec3 RING_TILES[12] = ivec3[](
+    ivec3(0, 0, -1), ivec3(1, 0, 1), ivec3(2, 0, 1), ivec3(3, 0, -1),
+    ivec3(0, 1, 2), ivec3(3, 1, 0), ivec3(0, 2, 2), ivec3(3, 2, 0),
+    ivec3(0, 3, -1), ivec3(1, 3, 3), ivec3(2, 3, 3), ivec3(3, 3, -1));
+
+vec2 clipmap_lattice()
+{
+    int t = mesh.tile_cells;
+    int grid = (t + 1) * (t + 1);
+    int tile = gl_VertexIndex / (grid + t);
+    int local = gl_VertexIndex - tile * (grid + t);
+
+    int level = 0;
+    ivec3 info = ivec3(tile % 4, tile / 4, -1);
+    if (tile >= 16) {
+        level = 1 + (tile - 16) / 12;
+        info = RING_TILES[(tile - 16) % 12];
+    }
+
+    float d = float(1 << level);
+    vec2 origin = vec2(info.xy * t - 2 * t) * d;
+    if (local < grid)
+        return origin + vec2(local % (t + 1), local / (t + 1)) * d;
+
+    // midpoints of the edge stitched to the finer level
+    float along = (float(local - grid) + 0.5) * d;
+    float edge = float(t) * d;
+    if (info.z == 0)
+        return origin + vec2(0.0, along);
+    if (info.z == 1)
+        return origin + vec2(along, edge);
+    if (info.z == 2)
+        return origin + vec2(edge, along);
+    return origin + vec2(along, 0.0);
+}
+#else
 layout(location = 0) in vec3 in_position;
 layout(location = 1) in vec2 in_tex_coords;
+#endif
 
-layout(set = 0, binding = 0) uniform sampler2D u_displacement_map;
+layout(set = 0, binding = 0) uniform sampler2D u_displacement_map[MAX_CASCADES];
 layout(std140, set = 0, binding = 2) uniform ViewData {
     uniform mat4    view_mat;
     uniform mat4    proj_mat;
@@ -38,18 +88,41 @@ layout(std140, set = 0, binding = 2) uniform ViewData {
     uniform float   z_range_max;
     uniform float   choppiness;
     uniform float   alt_scale;
+    uniform vec4    cascade_scale;
+    uniform int     cascade_count;
+    uniform vec2    grid_offset;
+    uniform vec2    grid_tex_offset;
 } view;
 
 void main()
 {
-    vec3 displ = texture(u_displacement_map, in_tex_coords).rbg; // swizzle
-    float z_bias = abs((displ.z - view.z_range_min) / (view.z_range_max - view.z_range_min));
+#ifdef VERTEX_PULLING
+    vec3 in_position = vec3(clipmap_lattice() * mesh.spacing, 0.0);
+    vec2 in_tex_coords = in_position.xy * mesh.inv_patch + 0.5;
+#endif
+
+    // clipmap mesh is centered on the camera, texture follows world position
+    vec2 tex_coords = in_tex_coords + view.grid_tex_offset;
+
+#ifdef TESSELLATION
+    // coarse patch corners, displaced per generated vertex in ocean.tese
+    ec_pos = vec4(in_position + vec3(view.grid_offset, 0.0), 1.0);
+    frag_tex_coord = tex_coords;
+#else
+    // cascades cover shorter patches with disjoint wave number bands
+    vec3 displ = vec3(0.0);
+    for (int i = 0; i < view.cascade_count; i++)
+        displ += texture(u_displacement_map[i], tex_coords * view.cascade_scale[i]).rbg; // swizzle
+    // clamped, summed cascades leave the base cascade range and cullTiles
+    // bounds assume the weight below 1
+    float z_bias = clamp(abs((displ.z - view.z_range_min) / (view.z_range_max - view.z_range_min)), 0.0, 1.0);
 
     displ.xy *= view.choppiness * (1.0+z_bias);
     displ.z *= view.alt_scale * mix(1.0, 1.3, pow(z_bias, 10.0));
 
-    vec3 ocean_vert = in_position + displ;
+    vec3 ocean_vert = in_position + vec3(view.grid_offset, 0.0) + displ;
     ec_pos = view.view_mat * vec4(ocean_vert, 1.0);
     gl_Position = view.proj_mat * ec_pos;
-    frag_tex_coord = in_tex_coords;
+    frag_tex_coord = tex_coords;
+#endif
 }
@@ -47,6 +47,107 @@ int main(int argc, char** argv)
         boost::program_options::value<unsigned short>(&app.opts.foam_technique)
             ->default_value(0),
         "foam technique (0 - default, 1 - Experimental, CFD based)")(
+        "backend",
+        boost::program_options::value<unsigned short>(&app.opts.compute_backend)
+            ->default_value(0),
+        "simulation backend (0 - OpenCL, 1 - Vulkan compute, 2 - CPU)")(
+        "cascades",
+        boost::program_options::value<size_t>(&app.opts.cascades)
+            ->default_value(1),
+        "number of FFT cascades summed by ocean shaders (1-4)")(
+        "cascade-ratio",
+        boost::program_options::value<float>(&app.opts.cascade_ratio)
+            ->default_value(4.f),
+        "patch length ratio of consecutive cascades")(
+        "clipmap-levels",
+        boost::program_options::value<size_t>(&app.opts.clipmap_levels)
+            ->default_value(4),
+        "number of LOD rings around camera centered ocean mesh (0-8)")(
+        "vertex-pulling",
+        boost::program_options::bool_switch(&app.opts.vertex_pulling),
+        "generate ocean mesh vertices in vertex shader without vertex buffer")(
+        "tessellation",
+        boost::program_options::bool_switch(&app.opts.tessellation),
+        "refine coarse ocean patches with tessellation shaders")(
+        "tess-edge-pixels",
+        boost::program_options::value<float>(&app.opts.tess_edge_pixels)
+            ->default_value(12.f),
+        "target screen-space edge length of tessellated triangles in pixels")(
+        "anisotropy",
+        boost::program_options::value<float>(&app.opts.anisotropy)
+            ->default_value(0.f),
+        "ocean texture anisotropic filtering (1 - trilinear, 0 - no mipmaps)")(
+        "pipeline-cache",
+        boost::program_options::value<std::string>(&app.opts.pipeline_cache)
+            ->default_value("pipeline_cache.bin"),
+        "Vulkan pipeline cache file, empty - no persistent cache")(
+        "frame-budget",
+        boost::program_options::value<float>(&app.opts.frame_budget)
+            ->default_value(0.f),
+        "scene GPU time target in ms lowering render resolution, 0 - native only")(
+        "min-render-scale",
+        boost::program_options::value<float>(&app.opts.min_render_scale)
+            ->default_value(0.5f),
+        "lowest render resolution relative to window (0.25-1)")(
+        "sim-buffers",
+        boost::program_options::value<size_t>(&app.opts.sim_buffers)
+            ->default_value(MAX_FRAMES_IN_FLIGHT),
+        "simulation textures and uniforms in flight (>= 2)")(
+        "present-mode",
+        boost::program_options::value<unsigned short>(&app.opts.present_mode)
+            ->default_value(1),
+        "present mode (0 - FIFO, 1 - mailbox, 2 - immediate)")(
+        "max-fps",
+        boost::program_options::value<float>(&app.opts.max_fps)
+            ->default_value(0.f),
+        "frame rate limit, 0 - unlimited")(
+        "frame-pacing",
+        boost::program_options::bool_switch(&app.opts.frame_pacing),
+        "start frame work just in time for --max-fps or refresh deadline")(
+        "stats-csv",
+        boost::program_options::value<std::string>(&app.opts.stats_csv),
+        "write per-frame timings to CSV file")(
+        "cfd-fused",
+        boost::program_options::bool_switch(&app.opts.cfd_fused_kernels),
+        "CFD foam: fuse divergence/pressure stages with Jacobi sweeps")(
+        "jacobi-block",
+        boost::program_options::value<unsigned short>(&app.opts.jacobi_block_steps)
+            ->default_value(1),
+        "CFD foam: Jacobi sweeps per launch using local memory halos")(
+        "cfd-queue",
+        boost::program_options::bool_switch(&app.opts.cfd_queue),
+        "CFD foam: run solver on a dedicated in-order queue")(
+        "cfd-device",
+        boost::program_options::value<int>(&app.opts.cfd_dev_index)->default_value(-1),
+        "CFD foam: OpenCL device index of the solver, -1 - same as ocean")(
+        "cfd-rate",
+        boost::program_options::value<float>(&app.opts.cfd_rate)->default_value(0.f),
+        "CFD foam: fixed update rate in Hz, 0 - every frame")(
+        "cfd-jacobi-iterations",
+        boost::program_options::value<unsigned short>(&app.opts.jacobi_iterations)
+            ->default_value(20),
+        "CFD foam: pressure solver relaxation sweeps per step")(
+        "cfd-substeps",
+        boost::program_options::value<unsigned short>(&app.opts.cfd_max_substeps)
+            ->default_value(4),
+        "CFD foam: maximal substeps per frame at fixed update rate")(
+        "cfd-device-dt",
+        boost::program_options::bool_switch(&app.opts.cfd_device_dt),
+        "CFD foam: compute time step on device without host readback")(
+        "cfd-advection",
+        boost::program_options::value<unsigned short>(&app.opts.cfd_advection)
+            ->default_value(0),
+        "CFD foam advection: 0 - semi-Lagrangian, 1 - MacCormack")(
+        "cfd-sparse",
+        boost::program_options::bool_switch(&app.opts.cfd_active_tiles),
+        "CFD foam: skip solver work in tiles without foam or velocity")(
+        "cfd-tile-threshold",
+        boost::program_options::value<float>(&app.opts.cfd_tile_threshold)
+            ->default_value(1e-3f),
+        "CFD foam: density/velocity magnitude keeping a sparse tile active")(
+        "cl-cmdbuf",
+        boost::program_options::bool_switch(&app.opts.commandBuffers),
+        "record OpenCL pipeline into replayable command buffers")(
         "platform,p",
         boost::program_options::value<unsigned short>(&app.opts.plat_index)
             ->default_value(0),
@@ -23,17 +23,65 @@ SOFTWARE.
 */
 #include "wave_app.hpp"
 #include "wave_compute_layer.hpp"
+#include "wave_cpu_layer.hpp"
 #include "wave_foam_compute_layer.hpp"
+#include "wave_vulkan_compute_layer.hpp"
 
 #include <iomanip>
 
 ////////////////////////////////////////////////////////////////////////////////
 void WaveApp::run() {
+  opts.cascades = std::min(std::max<size_t>(opts.cascades, 1), MAX_CASCADES);
+  if (opts.cascades > 1 && (opts.compute_backend != 0 || opts.foam_technique != 0)) {
+    printf("FFT cascades are available only on OpenCL backend with default "
+           "foam, using single cascade.\n");
+    opts.cascades = 1;
+  }
+  opts.clipmap_levels = std::min(opts.clipmap_levels, MAX_CLIPMAP_LEVELS);
+  if (opts.tessellation && opts.vertex_pulling) {
+    printf("Vertex pulling is not available with tessellation, using vertex "
+           "buffer.\n");
+    opts.vertex_pulling = false;
+  }
+  opts.min_render_scale =
+      std::min(std::max(opts.min_render_scale, 2.f * RENDER_SCALE_STEP), 1.f);
+  opts.sim_buffers =
+      std::max<size_t>(opts.sim_buffers, MAX_FRAMES_IN_FLIGHT);
+
   // create different models based on CLI options
-  if (opts.foam_technique==0)
+  if (opts.compute_backend == 1) {
+    if (opts.foam_technique != 0)
+      printf("CFD foam is not available on Vulkan compute backend, using "
+             "default foam.\n");
+    _model = std::make_unique<WaveVulkanComputeLayer>(opts);
+  } else if (opts.compute_backend == 2) {
+    if (opts.foam_technique != 0)
+      printf("CFD foam is not available on CPU backend, using default "
+             "foam.\n");
+    _model = std::make_unique<WaveCPULayer>(opts);
+  } else if (opts.foam_technique==0)
     _model = std::make_unique<WaveOpenCLLayer>(opts);
-  else
+  else {
+    if (opts.commandBuffers)
+      printf("OpenCL command buffers are not available with CFD foam, "
+             "enqueueing kernels every frame.\n");
+    opts.commandBuffers = false;
+
+    if (opts.cfd_dev_index >= 0) {
+      std::vector<cl::Platform> platforms;
+      cl::Platform::get(&platforms);
+      std::vector<cl::Device> devices;
+      if (opts.plat_index < platforms.size())
+        platforms[opts.plat_index].getDevices(CL_DEVICE_TYPE_ALL, &devices);
+      if (static_cast<size_t>(opts.cfd_dev_index) >= devices.size()) {
+        printf("CFD device %d is not available, running CFD solver on the "
+               "ocean device.\n",
+               opts.cfd_dev_index);
+        opts.cfd_dev_index = -1;
+      }
+    }
     _model = std::make_unique<WaveOpenCLFoamLayer>(opts);
+  }
 
     initWindow();
 
@@ -52,12 +100,21 @@ void WaveApp::initWindow()
   }
 
   glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-  glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+  glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
   window = glfwCreateWindow((int)opts.window_width, (int)opts.window_height,
                             "Ocean surface simulation with OpenCL and Vulkan",
                             nullptr, nullptr);
   glfwSetWindowUserPointer(window, this);
+
+  // just in time pacing needs a deadline, default to display refresh
+  if (opts.frame_pacing && opts.max_fps <= 0.f) {
+    const GLFWvidmode *mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    opts.max_fps = mode ? (float)mode->refreshRate : 60.f;
+    printf("Frame pacing without frame rate limit, using %.0f Hz display "
+           "refresh.\n",
+           opts.max_fps);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -67,9 +124,16 @@ void WaveApp::mainLoop()
   glfwSetMouseButtonCallback(window, mouse_event);
   glfwSetCursorPosCallback(window, mouse_pos);
   glfwSetScrollCallback(window, mouse_roll);
+  glfwSetFramebufferSizeCallback(window, framebuffer_resize);
 
   while (!glfwWindowShouldClose(window)) {
-    show_fps_window_title();
+    // nothing to present into while the window is minimized
+    if (opts.window_width == 0 || opts.window_height == 0) {
+      glfwWaitEvents();
+      continue;
+    }
+
+    show_stats_window_title();
     _model->drawFrame();
     glfwPollEvents();
   }
@@ -133,7 +197,6 @@ void WaveApp::keyboard(int key, int scancode, int action, int mods)
 
     case GLFW_KEY_W:
       opts.wireframe_mode = !opts.wireframe_mode;
-      _model->createCommandBuffers();
       break;
     }
   }
@@ -193,9 +256,22 @@ void WaveApp::mouse_roll(double offset_x, double offset_y)
   opts.camera.eye += opts.camera.dir * (float)offset_y * ROLL_SPEED_FAC;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+void WaveApp::framebuffer_resize(int width, int height)
+{
+  opts.window_width = static_cast<size_t>(width);
+  opts.window_height = static_cast<size_t>(height);
+  opts.resized = true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void WaveApp::cleanup()
 {
+  if (_model->stats().frames() > 0)
+    printf("Frame statistics over last %zu frames: %s\n",
+           _model->stats().frames(), _model->stats().summary().c_str());
+  _model->stats().flush();
+
   _model->cleanup();
   glfwDestroyWindow(window);
   glfwTerminate();
@@ -230,8 +306,15 @@ void WaveApp::mouse_roll(GLFWwindow *window, double oX, double oY)
   auto app = (WaveApp *)glfwGetWindowUserPointer(window);
   app->mouse_roll(oX, oY);
 }
+
+////////////////////////////////////////////////////////////////////////////////
+void WaveApp::framebuffer_resize(GLFWwindow *window, int width, int height)
+{
+  auto app = (WaveApp *)glfwGetWindowUserPointer(window);
+  app->framebuffer_resize(width, height);
+}
 ////////////////////////////////////////////////////////////////////////////////
-void WaveApp::show_fps_window_title()
+void WaveApp::show_stats_window_title()
 {
     auto app = (WaveApp *)glfwGetWindowUserPointer(window);
     if (app->opts.show_fps)
@@ -241,18 +324,18 @@ void WaveApp::show_fps_window_title()
         std::chrono::duration<float> elapsed = fps_now - fps_last_time;
         float delta = elapsed.count();
 
-        const float elapsed_tres = 1.f;
-
         delta_frames++;
         if (window && delta >= 1.f)
         {
             double fps = double(delta_frames) / delta;
 
+            // percentiles expose spikes which averaged FPS hides
             std::stringstream ss;
             ss << "Water sim app, [FPS:" << std::fixed << std::setprecision(2)
-               << fps << "]";
+               << fps << "] " << _model->stats().summary();
 
             glfwSetWindowTitle(window, ss.str().c_str());
+            _model->stats().flush();
 
             delta_frames = 0;
             fps_last_time = fps_now;
@@ -64,9 +64,11 @@ private:
 
   void mouse_roll(double offset_x, double offset_y);
 
+  void framebuffer_resize(int width, int height);
+
   void cleanup();
 
-  void show_fps_window_title();
+  void show_stats_window_title();
 
   static void keyboard(GLFWwindow *window, int key, int scancode, int action,
                        int mods);
@@ -76,5 +78,7 @@ private:
   static void mouse_pos(GLFWwindow *window, double pX, double pY);
 
   static void mouse_roll(GLFWwindow *window, double oX, double oY);
+
+  static void framebuffer_resize(GLFWwindow *window, int width, int height);
 };
 #endif //_WAVE_APP_HPP_
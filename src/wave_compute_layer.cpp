@@ -59,7 +59,7 @@ void WaveOpenCLLayer::initCompute() {
     printf("WaveOpenCLLayer::initCompute: clGetDeviceInfo error: %d\n", error);
 
   cl_device = devices[_opts.dev_index];
-  context = cl::Context{devices[_opts.dev_index]};
+  context = cl::Context{contextDevices(devices)};
   commandQueue = cl::CommandQueue{context, devices[_opts.dev_index]};
 
   if (_opts.technique == 0) {
@@ -67,11 +67,12 @@ void WaveOpenCLLayer::initCompute() {
   }
 
   auto build_kernel = [&](const char *src_file, cl::Kernel &kernel,
-                          const char *name) {
+                          const char *name,
+                          const std::string &options = std::string()) {
     try {
       std::string kernel_code = readFile(src_file).data();
       cl::Program program{context, kernel_code};
-      program.build();
+      program.build(options.c_str());
       kernel = cl::Kernel{program, name};
     } catch (const cl::BuildError &e) {
       auto bl = e.getBuildLog();
@@ -96,6 +97,69 @@ void WaveOpenCLLayer::initCompute() {
   build_kernel("kernels/reduce_ranges.cl", z_ranges_kernel, "reduce_ranges");
 
   setupFoamSolver("kernels/foam.cl");
+
+  if (_opts.commandBuffers) {
+    if (isExtensionSupported(cl_device(), "cl_khr_command_buffer")) {
+      loadCommandBufferFunctions(platforms[_opts.plat_index]);
+    } else {
+      printf("cl_khr_command_buffer not supported, pipeline enqueued every "
+             "frame.\n");
+    }
+  }
+
+  if (useCommandBuffers()) {
+    build_kernel("kernels/time_spectrum.cl", time_spectrum_cb_kernel,
+                 "spectrum", "-DTIME_FROM_BUFFER");
+    build_kernel("kernels/foam.cl", foam_cb_kernel, "update_foam",
+                 "-DZRANGE_FROM_IMAGE");
+    build_kernel("kernels/copy.cl", copy_cb_kernel, "copy");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector<cl::Device>
+WaveOpenCLLayer::contextDevices(const std::vector<cl::Device> &devices) {
+  return {devices[_opts.dev_index]};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveOpenCLLayer::readRangeLevels() {
+  // texel at the origin keeps the sampling z range always had for shading
+  z_range = glm::vec2(range_levels[0], range_levels[1]);
+
+  displ_bound = glm::vec2(0.f);
+  for (size_t cascade = 0; cascade < _opts.cascades; cascade++)
+    displ_bound +=
+        range_level_bound(&range_levels[cascade * RANGE_LEVEL_FLOATS]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveOpenCLLayer::loadCommandBufferFunctions(cl::Platform &platform) {
+#define GET_EXTENSION_FUNCTION(_var, _name)                                    \
+  _var = reinterpret_cast<decltype(_var)>(                                     \
+      clGetExtensionFunctionAddressForPlatform(platform(), #_name));
+
+  GET_EXTENSION_FUNCTION(createCommandBufferKHR, clCreateCommandBufferKHR);
+  GET_EXTENSION_FUNCTION(finalizeCommandBufferKHR, clFinalizeCommandBufferKHR);
+  GET_EXTENSION_FUNCTION(commandNDRangeKernelKHR, clCommandNDRangeKernelKHR);
+  GET_EXTENSION_FUNCTION(releaseCommandBufferKHR, clReleaseCommandBufferKHR);
+  GET_EXTENSION_FUNCTION(enqueueCommandBufferKHR, clEnqueueCommandBufferKHR);
+#undef GET_EXTENSION_FUNCTION
+
+  if (!createCommandBufferKHR || !finalizeCommandBufferKHR ||
+      !commandNDRangeKernelKHR || !releaseCommandBufferKHR ||
+      !enqueueCommandBufferKHR) {
+    printf("WaveOpenCLLayer::loadCommandBufferFunctions: cl_khr_command_buffer "
+           "entry points not found.\n");
+    enqueueCommandBufferKHR = nullptr;
+    return;
+  }
+
+  printf("cl_khr_command_buffer supported, OpenCL pipeline recorded per "
+         "resource slot.\n");
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -122,7 +186,8 @@ void WaveOpenCLLayer::setupFoamSolver(const std::string &filename) {
 void WaveOpenCLLayer::initComputeResources() {
   // init intermediate opencl resources
   try {
-    {
+    // each cascade gets its own random phases and initial spectrum
+    for (size_t cascade = 0; cascade < _opts.cascades; cascade++) {
       std::vector<cl_float4> phase_array(_opts.ocean_tex_size *
                                          _opts.ocean_tex_size);
       std::random_device dev;
@@ -132,10 +197,14 @@ void WaveOpenCLLayer::initComputeResources() {
       for (size_t i = 0; i < phase_array.size(); ++i)
         phase_array[i] = {dist(rng), dist(rng), dist(rng), dist(rng)};
 
-      noise_mem = std::make_unique<cl::Image2D>(
+      noise_mem[cascade] = std::make_unique<cl::Image2D>(
           context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
           cl::ImageFormat(CL_RGBA, CL_FLOAT), _opts.ocean_tex_size,
           _opts.ocean_tex_size, 0, phase_array.data());
+
+      h0k_mem[cascade] = std::make_unique<cl::Image2D>(
+          context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_FLOAT),
+          _opts.ocean_tex_size, _opts.ocean_tex_size);
     }
 
     hkt_pong_mem = std::make_unique<cl::Image2D>(
@@ -154,16 +223,13 @@ void WaveOpenCLLayer::initComputeResources() {
         context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RG, CL_FLOAT),
         _opts.ocean_tex_size, _opts.ocean_tex_size);
 
-    h0k_mem = std::make_unique<cl::Image2D>(
-        context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_FLOAT),
-        _opts.ocean_tex_size, _opts.ocean_tex_size);
-
+    // height range and largest horizontal displacement
     z_ranges_mem[0] = std::make_unique<cl::Image2D>(
-        context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RG, CL_FLOAT),
+        context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_FLOAT),
         _opts.ocean_tex_size, _opts.ocean_tex_size);
 
     z_ranges_mem[1] = std::make_unique<cl::Image2D>(
-        context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RG, CL_FLOAT),
+        context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_FLOAT),
         _opts.ocean_tex_size / 2, _opts.ocean_tex_size / 2);
 
     size_t log_2_N =
@@ -173,9 +239,9 @@ void WaveOpenCLLayer::initComputeResources() {
         _opts.ocean_tex_size);
 
     for (size_t target = 0; target < IOPT_COUNT; target++) {
-      mems[target].resize(_vulkan.swapChainImages.size());
+      mems[target].resize(_vulkan.textureImages[target].images.size());
 
-      for (size_t i = 0; i < _vulkan.swapChainImages.size(); i++) {
+      for (size_t i = 0; i < mems[target].size(); i++) {
         if (_opts.useExternalMemory) {
 #ifdef _WIN32
           HANDLE handle = NULL;
@@ -188,9 +254,13 @@ void WaveOpenCLLayer::initComputeResources() {
               VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_BIT;
           vkGetMemoryWin32HandleKHR(device, &getWin32HandleInfo, &handle);
 
+          // imported images stay on the simulation device of the context
           const cl_mem_properties props[] = {
               externalMemType,
               (cl_mem_properties)handle,
+              CL_MEM_DEVICE_HANDLE_LIST_KHR,
+              (cl_mem_properties)cl_device(),
+              CL_MEM_DEVICE_HANDLE_LIST_END_KHR,
               0,
           };
 #elif defined(__linux__)
@@ -205,9 +275,13 @@ void WaveOpenCLLayer::initComputeResources() {
                   : VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
           vkGetMemoryFdKHR(_vulkan.device, &getFdInfo, &fd);
 
+          // imported images stay on the simulation device of the context
           const cl_mem_properties props[] = {
               externalMemType,
               (cl_mem_properties)fd,
+              CL_MEM_DEVICE_HANDLE_LIST_KHR,
+              (cl_mem_properties)cl_device(),
+              CL_MEM_DEVICE_HANDLE_LIST_END_KHR,
               0,
           };
 #else
@@ -247,6 +321,18 @@ void WaveOpenCLLayer::initComputeResources() {
         }
       }
     }
+
+    if (useCommandBuffers()) {
+      // recorded lazily on first use of each resource slot
+      time_mem = std::make_unique<cl::Buffer>(context, CL_MEM_READ_ONLY,
+                                              sizeof(cl_float));
+      command_buffers.resize(slotCount(), nullptr);
+
+      for (size_t cascade = 1; cascade < _opts.cascades; cascade++)
+        cascade_ranges_mem[cascade] = std::make_unique<cl::Image2D>(
+            context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_FLOAT),
+            RANGE_LEVEL_SIZE, RANGE_LEVEL_SIZE);
+    }
   } catch (const cl::Error &e) {
     printf("WaveOpenCLLayer::initComputeResources: OpenCL %s image error: %s\n",
            e.what(), IGetErrorString(e.err()));
@@ -261,6 +347,12 @@ void WaveOpenCLLayer::cleanup() {
     semaphore.release();
   }
 
+  for (auto command_buffer : command_buffers) {
+    if (command_buffer)
+      releaseCommandBufferKHR(command_buffer);
+  }
+  command_buffers.clear();
+
   WaveVulkanLayer::cleanup();
 }
 
@@ -375,14 +467,20 @@ void WaveOpenCLLayer::updateSimulation(uint32_t currentImage, float elapsed) {
           cl_float4{_opts.wind_magnitude * glm::cos(wind_angle_rad),
                     _opts.wind_magnitude * glm::sin(wind_angle_rad),
                     _opts.amplitude, _opts.supress_factor};
-      init_spectrum_kernel.setArg(0, patch);
-      init_spectrum_kernel.setArg(1, params);
-      init_spectrum_kernel.setArg(2, *noise_mem);
-      init_spectrum_kernel.setArg(3, *h0k_mem);
-
-      commandQueue.enqueueNDRangeKernel(
-          init_spectrum_kernel, cl::NullRange,
-          cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws);
+      for (size_t cascade = 0; cascade < _opts.cascades; cascade++) {
+        glm::vec2 band = cascade_band(_opts, cascade);
+        init_spectrum_kernel.setArg(
+            0, cl_int2{cascade_patch_size(_opts, cascade),
+                       (int)_opts.ocean_tex_size});
+        init_spectrum_kernel.setArg(1, params);
+        init_spectrum_kernel.setArg(2, *noise_mem[cascade]);
+        init_spectrum_kernel.setArg(3, *h0k_mem[cascade]);
+        init_spectrum_kernel.setArg(4, cl_float2{band.x, band.y});
+
+        commandQueue.enqueueNDRangeKernel(
+            init_spectrum_kernel, cl::NullRange,
+            cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws);
+      }
       _opts.changed = false;
     } catch (const cl::Error &e) {
       printf("WaveOpenCLLayer::updateSimulation: initial spectrum: OpenCL %s "
@@ -392,150 +490,375 @@ void WaveOpenCLLayer::updateSimulation(uint32_t currentImage, float elapsed) {
     }
   }
 
-  // ping-pong phase spectrum kernel launch
-  try {
-    time_spectrum_kernel.setArg(0, elapsed);
-    time_spectrum_kernel.setArg(1, patch);
-    time_spectrum_kernel.setArg(2, *h0k_mem);
-    time_spectrum_kernel.setArg(3, *dxyz_coef_mem[0]);
-    time_spectrum_kernel.setArg(4, *dxyz_coef_mem[1]);
-    time_spectrum_kernel.setArg(5, *dxyz_coef_mem[2]);
-
-    commandQueue.enqueueNDRangeKernel(
-        time_spectrum_kernel, cl::NullRange,
-        cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws);
-  } catch (const cl::Error &e) {
-    printf("WaveOpenCLLayer::updateSimulation: updateSimulation: OpenCL %s "
-           "kernel error: %s\n",
-           e.what(), IGetErrorString(e.err()));
-    exit(1);
+  if (useCommandBuffers()) {
+    replayCommandBuffer(currentImage, elapsed);
+    return;
   }
 
-  // perform 1D FFT horizontal and vertical iterations
-  size_t log_2_N = (size_t)((log((float)_opts.ocean_tex_size) / log(2.f)) - 1);
-  fft_kernel.setArg(1, patch);
-  fft_kernel.setArg(2, *twiddle_factors_mem);
-  for (cl_int i = 0; i < 3; i++) {
-    const cl::Image *displ_swap[] = {dxyz_coef_mem[i].get(),
-                                     hkt_pong_mem.get()};
-    cl_int2 mode = (cl_int2){0, 0};
-
-    bool ifft_pingpong = false;
-    for (int p = 0; p < log_2_N; p++) {
-      if (ifft_pingpong) {
-        fft_kernel.setArg(3, *displ_swap[1]);
-        fft_kernel.setArg(4, *displ_swap[0]);
-      } else {
-        fft_kernel.setArg(3, *displ_swap[0]);
-        fft_kernel.setArg(4, *displ_swap[1]);
+  if (_opts.useExternalMemory) {
+    for (size_t target = 0; target < IOPT_COUNT; target++) {
+      for (size_t cascade = 0; cascade < _opts.cascades; cascade++) {
+        commandQueue.enqueueAcquireExternalMemObjects(
+            {*mems[target][cascadeImage(currentImage, cascade)]});
       }
+    }
+  }
+
+  size_t log_2_N = (size_t)((log((float)_opts.ocean_tex_size) / log(2.f)) - 1);
 
-      mode.s[1] = p;
-      fft_kernel.setArg(0, mode);
+  // cascades share intermediate images, base cascade goes last so its z range
+  // reduction is not overwritten by the following inversions
+  for (size_t cascade = _opts.cascades; cascade-- > 0;) {
+    cl_int2 cascade_patch = cl_int2{cascade_patch_size(_opts, cascade),
+                                    (int)_opts.ocean_tex_size};
+    size_t image = cascadeImage(currentImage, cascade);
+
+    // ping-pong phase spectrum kernel launch
+    try {
+      time_spectrum_kernel.setArg(0, elapsed);
+      time_spectrum_kernel.setArg(1, cascade_patch);
+      time_spectrum_kernel.setArg(2, *h0k_mem[cascade]);
+      time_spectrum_kernel.setArg(3, *dxyz_coef_mem[0]);
+      time_spectrum_kernel.setArg(4, *dxyz_coef_mem[1]);
+      time_spectrum_kernel.setArg(5, *dxyz_coef_mem[2]);
 
       commandQueue.enqueueNDRangeKernel(
-          fft_kernel, cl::NullRange,
+          time_spectrum_kernel, cl::NullRange,
           cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws);
-
-      ifft_pingpong = !ifft_pingpong;
+    } catch (const cl::Error &e) {
+      printf("WaveOpenCLLayer::updateSimulation: updateSimulation: OpenCL %s "
+             "kernel error: %s\n",
+             e.what(), IGetErrorString(e.err()));
+      exit(1);
     }
 
-    // Cols
-    mode.s[0] = 1;
-    for (int p = 0; p < log_2_N; p++) {
-      if (ifft_pingpong) {
-        fft_kernel.setArg(3, *displ_swap[1]);
-        fft_kernel.setArg(4, *displ_swap[0]);
-      } else {
-        fft_kernel.setArg(3, *displ_swap[0]);
-        fft_kernel.setArg(4, *displ_swap[1]);
+    // perform 1D FFT horizontal and vertical iterations
+    fft_kernel.setArg(1, cascade_patch);
+    fft_kernel.setArg(2, *twiddle_factors_mem);
+    for (cl_int i = 0; i < 3; i++) {
+      const cl::Image *displ_swap[] = {dxyz_coef_mem[i].get(),
+                                       hkt_pong_mem.get()};
+      cl_int2 mode = (cl_int2){0, 0};
+
+      bool ifft_pingpong = false;
+      for (int p = 0; p < log_2_N; p++) {
+        if (ifft_pingpong) {
+          fft_kernel.setArg(3, *displ_swap[1]);
+          fft_kernel.setArg(4, *displ_swap[0]);
+        } else {
+          fft_kernel.setArg(3, *displ_swap[0]);
+          fft_kernel.setArg(4, *displ_swap[1]);
+        }
+
+        mode.s[1] = p;
+        fft_kernel.setArg(0, mode);
+
+        commandQueue.enqueueNDRangeKernel(
+            fft_kernel, cl::NullRange,
+            cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws);
+
+        ifft_pingpong = !ifft_pingpong;
+      }
+
+      // Cols
+      mode.s[0] = 1;
+      for (int p = 0; p < log_2_N; p++) {
+        if (ifft_pingpong) {
+          fft_kernel.setArg(3, *displ_swap[1]);
+          fft_kernel.setArg(4, *displ_swap[0]);
+        } else {
+          fft_kernel.setArg(3, *displ_swap[0]);
+          fft_kernel.setArg(4, *displ_swap[1]);
+        }
+
+        mode.s[1] = p;
+        fft_kernel.setArg(0, mode);
+
+        commandQueue.enqueueNDRangeKernel(
+            fft_kernel, cl::NullRange,
+            cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws);
+
+        ifft_pingpong = !ifft_pingpong;
+      }
+
+      if (log_2_N % 2) {
+        // swap images if pingpong hold on temporary buffer
+        std::array<size_t, 3> orig = {0, 0, 0},
+                              region = {_opts.ocean_tex_size,
+                                        _opts.ocean_tex_size, 1};
+        commandQueue.enqueueCopyImage(*displ_swap[0], *displ_swap[1], orig,
+                                      orig, region);
       }
+    }
 
-      mode.s[1] = p;
-      fft_kernel.setArg(0, mode);
+    // inversion
+    {
+      inversion_kernel.setArg(0, cascade_patch);
+      inversion_kernel.setArg(1, *dxyz_coef_mem[0]);
+      inversion_kernel.setArg(2, *dxyz_coef_mem[1]);
+      inversion_kernel.setArg(3, *dxyz_coef_mem[2]);
+      inversion_kernel.setArg(4, *mems[IOPT_DISPLACEMENT][image]);
+      inversion_kernel.setArg(5, *z_ranges_mem[0]);
 
       commandQueue.enqueueNDRangeKernel(
-          fft_kernel, cl::NullRange,
+          inversion_kernel, cl::NullRange,
           cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws);
+    }
 
-      ifft_pingpong = !ifft_pingpong;
+    // min max reduction of every cascade bounds culled tiles, only the base
+    // cascade feeds z range
+    {
+      cl::NDRange lws = cl::NDRange{_opts.group_size, _opts.group_size};
+      cl_int2 patch =
+          cl_int2{(int)_opts.ocean_tex_size / 2, (int)_opts.ocean_tex_size / 2};
+      for (int p = 0; p < log_2_N; p++) {
+        z_ranges_kernel.setArg(0, patch);
+        z_ranges_kernel.setArg(1, *z_ranges_mem[p % 2]);
+        z_ranges_kernel.setArg(2, *z_ranges_mem[(p + 1) % 2]);
+
+        commandQueue.enqueueNDRangeKernel(
+            z_ranges_kernel, cl::NullRange,
+            cl::NDRange{(cl::size_type)patch.x, (cl::size_type)patch.y}, lws);
+
+        patch = cl_int2{patch.x / 2, patch.y / 2};
+        if (patch.x < lws.get()[0])
+          lws = cl::NDRange{(cl::size_type)patch.x, (cl::size_type)patch.y};
+      }
+      // in-order queue, blocking read of the base cascade waits for all
+      float *level = &range_levels[cascade * RANGE_LEVEL_FLOATS];
+      commandQueue.enqueueReadImage(
+          *z_ranges_mem[log_2_N % 2], cascade == 0,
+          cl::array<cl::size_type, 2>{0, 0},
+          cl::array<cl::size_type, 2>{RANGE_LEVEL_SIZE, RANGE_LEVEL_SIZE}, 0, 0,
+          level);
+      if (cascade == 0)
+        readRangeLevels();
     }
 
-    if (log_2_N % 2) {
-      // swap images if pingpong hold on temporary buffer
-      std::array<size_t, 3> orig = {0, 0, 0},
-                            region = {_opts.ocean_tex_size,
-                                      _opts.ocean_tex_size, 1};
-      commandQueue.enqueueCopyImage(*displ_swap[0], *displ_swap[1], orig, orig,
-                                    region);
+    // normals computation
+    {
+      normals_kernel.setArg(0, cascade_patch);
+      normals_kernel.setArg(1, *mems[IOPT_DISPLACEMENT][image]);
+      normals_kernel.setArg(2, *mems[IOPT_NORMAL_MAP][image]);
+      normals_kernel.setArg(3, *mems[IOPT_NORMAL_MAP][image]);
+
+      commandQueue.enqueueNDRangeKernel(
+          normals_kernel, cl::NullRange,
+          cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws);
     }
   }
 
+  computeFoam(currentImage, patch);
+
   if (_opts.useExternalMemory) {
     for (size_t target = 0; target < IOPT_COUNT; target++) {
-      commandQueue.enqueueAcquireExternalMemObjects(
-          {*mems[target][currentImage]});
+      for (size_t cascade = 0; cascade < _opts.cascades; cascade++) {
+        commandQueue.enqueueReleaseExternalMemObjects(
+            {*mems[target][cascadeImage(currentImage, cascade)]});
+      }
     }
   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveOpenCLLayer::recordCommandBuffer(uint32_t currentImage) {
+  cl_int2 patch = cl_int2{(int)(_opts.ocean_grid_size * _opts.mesh_spacing),
+                          (int)_opts.ocean_tex_size};
+  cl::NDRange lws = cl::NDRange{_opts.group_size, _opts.group_size};
+  cl::NDRange gws = cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size};
+
+  cl_int err = CL_SUCCESS;
+  cl_command_queue queue = commandQueue();
+  cl_command_buffer_khr command_buffer =
+      createCommandBufferKHR(1, &queue, nullptr, &err);
+  if (err != CL_SUCCESS) {
+    printf("WaveOpenCLLayer::recordCommandBuffer: clCreateCommandBufferKHR "
+           "error: %s\n",
+           IGetErrorString(err));
+    exit(1);
+  }
+
+  // kernel arguments are captured at record time, commands of a buffer
+  // created on in-order queue execute in order
+  auto record = [&](cl::Kernel &kernel, const cl::NDRange &global,
+                    const cl::NDRange &local) {
+    err = commandNDRangeKernelKHR(command_buffer, nullptr, nullptr, kernel(),
+                                  (cl_uint)global.dimensions(), nullptr,
+                                  global, local, 0, nullptr, nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+      printf("WaveOpenCLLayer::recordCommandBuffer: "
+             "clCommandNDRangeKernelKHR error: %s\n",
+             IGetErrorString(err));
+      exit(1);
+    }
+  };
+
+  size_t log_2_N = (size_t)((log((float)_opts.ocean_tex_size) / log(2.f)) - 1);
 
-  // inversion
-  {
-    inversion_kernel.setArg(0, patch);
+  // same cascade order as updateSimulation, base cascade recorded last
+  for (size_t cascade = _opts.cascades; cascade-- > 0;) {
+    cl_int2 cascade_patch = cl_int2{cascade_patch_size(_opts, cascade),
+                                    (int)_opts.ocean_tex_size};
+    size_t image = cascadeImage(currentImage, cascade);
+
+    time_spectrum_cb_kernel.setArg(0, *time_mem);
+    time_spectrum_cb_kernel.setArg(1, cascade_patch);
+    time_spectrum_cb_kernel.setArg(2, *h0k_mem[cascade]);
+    time_spectrum_cb_kernel.setArg(3, *dxyz_coef_mem[0]);
+    time_spectrum_cb_kernel.setArg(4, *dxyz_coef_mem[1]);
+    time_spectrum_cb_kernel.setArg(5, *dxyz_coef_mem[2]);
+    record(time_spectrum_cb_kernel, gws, lws);
+
+    fft_kernel.setArg(1, cascade_patch);
+    fft_kernel.setArg(2, *twiddle_factors_mem);
+    for (cl_int i = 0; i < 3; i++) {
+      const cl::Image *displ_swap[] = {dxyz_coef_mem[i].get(),
+                                       hkt_pong_mem.get()};
+      bool ifft_pingpong = false;
+
+      // rows then cols
+      for (int dir = 0; dir < 2; dir++) {
+        for (int p = 0; p < log_2_N; p++) {
+          int src = ifft_pingpong ? 1 : 0;
+          fft_kernel.setArg(0, cl_int2{dir, p});
+          fft_kernel.setArg(3, *displ_swap[src]);
+          fft_kernel.setArg(4, *displ_swap[1 - src]);
+          record(fft_kernel, gws, lws);
+
+          ifft_pingpong = !ifft_pingpong;
+        }
+      }
+
+      if (log_2_N % 2) {
+        // image copy through kernel, keeps recording to ND-range commands
+        copy_cb_kernel.setArg(0, *displ_swap[0]);
+        copy_cb_kernel.setArg(1, *displ_swap[1]);
+        record(copy_cb_kernel, gws, lws);
+      }
+    }
+
+    inversion_kernel.setArg(0, cascade_patch);
     inversion_kernel.setArg(1, *dxyz_coef_mem[0]);
     inversion_kernel.setArg(2, *dxyz_coef_mem[1]);
     inversion_kernel.setArg(3, *dxyz_coef_mem[2]);
-    inversion_kernel.setArg(4, *mems[IOPT_DISPLACEMENT][currentImage]);
+    inversion_kernel.setArg(4, *mems[IOPT_DISPLACEMENT][image]);
     inversion_kernel.setArg(5, *z_ranges_mem[0]);
+    record(inversion_kernel, gws, lws);
 
-    commandQueue.enqueueNDRangeKernel(
-        inversion_kernel, cl::NullRange,
-        cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws);
-  }
+    {
+      cl::NDRange lws = cl::NDRange{_opts.group_size, _opts.group_size};
+      cl_int2 patch =
+          cl_int2{(int)_opts.ocean_tex_size / 2, (int)_opts.ocean_tex_size / 2};
+      for (int p = 0; p < log_2_N; p++) {
+        z_ranges_kernel.setArg(0, patch);
+        z_ranges_kernel.setArg(1, *z_ranges_mem[p % 2]);
+        z_ranges_kernel.setArg(2, *z_ranges_mem[(p + 1) % 2]);
+        record(z_ranges_kernel,
+               cl::NDRange{(cl::size_type)patch.x, (cl::size_type)patch.y},
+               lws);
+
+        patch = cl_int2{patch.x / 2, patch.y / 2};
+        if (patch.x < lws.get()[0])
+          lws = cl::NDRange{(cl::size_type)patch.x, (cl::size_type)patch.y};
+      }
 
-  // min max reduction
-  {
-    cl::NDRange lws = cl::NDRange{_opts.group_size, _opts.group_size};
-    cl_int2 patch =
-        cl_int2{(int)_opts.ocean_tex_size / 2, (int)_opts.ocean_tex_size / 2};
-    for (int p = 0; p < log_2_N; p++) {
-      z_ranges_kernel.setArg(0, patch);
-      z_ranges_kernel.setArg(1, *z_ranges_mem[p % 2]);
-      z_ranges_kernel.setArg(2, *z_ranges_mem[(p + 1) % 2]);
+      // following cascades overwrite the level, base cascade keeps it
+      if (cascade > 0) {
+        copy_cb_kernel.setArg(0, *z_ranges_mem[log_2_N % 2]);
+        copy_cb_kernel.setArg(1, *cascade_ranges_mem[cascade]);
+        cl::NDRange level{RANGE_LEVEL_SIZE, RANGE_LEVEL_SIZE};
+        record(copy_cb_kernel, level, level);
+      }
+    }
 
-      commandQueue.enqueueNDRangeKernel(
-          z_ranges_kernel, cl::NullRange,
-          cl::NDRange{(cl::size_type)patch.x, (cl::size_type)patch.y}, lws);
+    normals_kernel.setArg(0, cascade_patch);
+    normals_kernel.setArg(1, *mems[IOPT_DISPLACEMENT][image]);
+    normals_kernel.setArg(2, *mems[IOPT_NORMAL_MAP][image]);
+    normals_kernel.setArg(3, *mems[IOPT_NORMAL_MAP][image]);
+    record(normals_kernel, gws, lws);
+  }
 
-      patch = cl_int2{patch.x / 2, patch.y / 2};
-      if (patch.x < lws.get()[0])
-        lws = cl::NDRange{(cl::size_type)patch.x, (cl::size_type)patch.y};
-    }
-    float buf[2] = {0, 0};
-    commandQueue.enqueueReadImage(*z_ranges_mem[log_2_N % 2], true,
-                                  cl::array<cl::size_type, 2>{0, 0},
-                                  cl::array<cl::size_type, 2>{1, 1}, 0, 0, buf);
-    z_range = glm::vec2(buf[0], buf[1]);
+  // z range comes from the reduction result instead of host readback
+  foam_cb_kernel.setArg(0, patch);
+  foam_cb_kernel.setArg(
+      1, cl_float3{0.f, 0.f, _opts.technique == 0 ? 2.f : 8.f});
+  foam_cb_kernel.setArg(2, *noise_mem[0]);
+  foam_cb_kernel.setArg(3, *mems[IOPT_DISPLACEMENT][currentImage]);
+  foam_cb_kernel.setArg(4, *mems[IOPT_NORMAL_MAP][currentImage]);
+  foam_cb_kernel.setArg(5, *mems[IOPT_NORMAL_MAP][currentImage]);
+  foam_cb_kernel.setArg(6, *z_ranges_mem[log_2_N % 2]);
+  record(foam_cb_kernel, gws, lws);
+
+  err = finalizeCommandBufferKHR(command_buffer);
+  if (err != CL_SUCCESS) {
+    printf("WaveOpenCLLayer::recordCommandBuffer: clFinalizeCommandBufferKHR "
+           "error: %s\n",
+           IGetErrorString(err));
+    exit(1);
   }
 
-  // normals computation
-  {
-    normals_kernel.setArg(0, patch);
-    normals_kernel.setArg(1, *mems[IOPT_DISPLACEMENT][currentImage]);
-    normals_kernel.setArg(2, *mems[IOPT_NORMAL_MAP][currentImage]);
-    normals_kernel.setArg(3, *mems[IOPT_NORMAL_MAP][currentImage]);
+  command_buffers[currentImage] = command_buffer;
+}
 
-    commandQueue.enqueueNDRangeKernel(
-        normals_kernel, cl::NullRange,
-        cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws);
-  }
+////////////////////////////////////////////////////////////////////////////////
 
-  computeFoam(currentImage, patch);
+void WaveOpenCLLayer::replayCommandBuffer(uint32_t currentImage,
+                                          float elapsed) {
+  if (!command_buffers[currentImage])
+    recordCommandBuffer(currentImage);
 
-  if (_opts.useExternalMemory) {
-    for (size_t target = 0; target < IOPT_COUNT; target++) {
-      commandQueue.enqueueReleaseExternalMemObjects(
-          {*mems[target][currentImage]});
+  try {
+    // the only per-frame input of recorded pipeline
+    cb_elapsed = elapsed;
+    commandQueue.enqueueWriteBuffer(*time_mem, CL_FALSE, 0, sizeof(cl_float),
+                                    &cb_elapsed);
+
+    if (_opts.useExternalMemory) {
+      for (size_t target = 0; target < IOPT_COUNT; target++) {
+        for (size_t cascade = 0; cascade < _opts.cascades; cascade++) {
+          commandQueue.enqueueAcquireExternalMemObjects(
+              {*mems[target][cascadeImage(currentImage, cascade)]});
+        }
+      }
     }
+
+    cl_int err = enqueueCommandBufferKHR(0, nullptr,
+                                         command_buffers[currentImage], 0,
+                                         nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+      printf("WaveOpenCLLayer::replayCommandBuffer: clEnqueueCommandBufferKHR "
+             "error: %s\n",
+             IGetErrorString(err));
+      exit(1);
+    }
+
+    // z range is still needed on host by the vertex shader uniforms and
+    // bounds of all cascades by culling, the last blocking read waits for all
+    size_t log_2_N =
+        (size_t)((log((float)_opts.ocean_tex_size) / log(2.f)) - 1);
+    for (size_t cascade = _opts.cascades; cascade-- > 0;) {
+      const cl::Image2D &level = cascade > 0 ? *cascade_ranges_mem[cascade]
+                                             : *z_ranges_mem[log_2_N % 2];
+      commandQueue.enqueueReadImage(
+          level, cascade == 0, cl::array<cl::size_type, 2>{0, 0},
+          cl::array<cl::size_type, 2>{RANGE_LEVEL_SIZE, RANGE_LEVEL_SIZE}, 0, 0,
+          &range_levels[cascade * RANGE_LEVEL_FLOATS]);
+    }
+    readRangeLevels();
+
+    if (_opts.useExternalMemory) {
+      for (size_t target = 0; target < IOPT_COUNT; target++) {
+        for (size_t cascade = 0; cascade < _opts.cascades; cascade++) {
+          commandQueue.enqueueReleaseExternalMemObjects(
+              {*mems[target][cascadeImage(currentImage, cascade)]});
+        }
+      }
+    }
+  } catch (const cl::Error &e) {
+    printf("WaveOpenCLLayer::replayCommandBuffer: OpenCL %s error: %s\n",
+           e.what(), IGetErrorString(e.err()));
+    exit(1);
   }
 }
 
@@ -551,7 +874,7 @@ void WaveOpenCLLayer::computeFoam(const uint32_t currentImage,
 
   foam_kernel.setArg(0, patch);
   foam_kernel.setArg(1, zr);
-  foam_kernel.setArg(2, *noise_mem);
+  foam_kernel.setArg(2, *noise_mem[0]);
   foam_kernel.setArg(3, *mems[IOPT_DISPLACEMENT][currentImage]);
   foam_kernel.setArg(4, *mems[IOPT_NORMAL_MAP][currentImage]);
   foam_kernel.setArg(5, *mems[IOPT_NORMAL_MAP][currentImage]);
@@ -584,36 +907,39 @@ void WaveOpenCLLayer::updateSolver(uint32_t currentImage) {
       commandQueue.finish();
     } else {
       for (size_t target = 0; target < IOPT_COUNT; target++) {
-        size_t rowPitch = 0;
-        void *pixels = commandQueue.enqueueMapImage(
-            *mems[target][currentImage], CL_TRUE, CL_MAP_READ, {0, 0, 0},
-            {_opts.ocean_tex_size, _opts.ocean_tex_size, 1}, &rowPitch,
-            nullptr);
-
-        VkDeviceSize imageSize =
-            _opts.ocean_tex_size * _opts.ocean_tex_size * 4 * sizeof(float);
-
-        void *data;
-        vkMapMemory(_vulkan.device, _vulkan.stagingBufferMemory, 0, imageSize,
-                    0, &data);
-        memcpy(data, pixels, static_cast<size_t>(imageSize));
-        vkUnmapMemory(_vulkan.device, _vulkan.stagingBufferMemory);
-
-        commandQueue.enqueueUnmapMemObject(*mems[target][currentImage], pixels);
-        commandQueue.flush();
-
-        transitionImageLayout(
-            _vulkan.textureImages[target].images[currentImage],
-            VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        copyBufferToImage(_vulkan.stagingBuffer,
-                          _vulkan.textureImages[target].images[currentImage],
-                          static_cast<uint32_t>(_opts.ocean_tex_size),
-                          static_cast<uint32_t>(_opts.ocean_tex_size));
-        transitionImageLayout(
-            _vulkan.textureImages[target].images[currentImage],
-            VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        for (size_t cascade = 0; cascade < _opts.cascades; cascade++) {
+          size_t image = cascadeImage(currentImage, cascade);
+          size_t rowPitch = 0;
+          void *pixels = commandQueue.enqueueMapImage(
+              *mems[target][image], CL_TRUE, CL_MAP_READ, {0, 0, 0},
+              {_opts.ocean_tex_size, _opts.ocean_tex_size, 1}, &rowPitch,
+              nullptr);
+
+          VkDeviceSize imageSize =
+              _opts.ocean_tex_size * _opts.ocean_tex_size * 4 * sizeof(float);
+
+          void *data;
+          vkMapMemory(_vulkan.device, _vulkan.stagingBufferMemory, 0,
+                      imageSize, 0, &data);
+          memcpy(data, pixels, static_cast<size_t>(imageSize));
+          vkUnmapMemory(_vulkan.device, _vulkan.stagingBufferMemory);
+
+          commandQueue.enqueueUnmapMemObject(*mems[target][image], pixels);
+          commandQueue.flush();
+
+          transitionImageLayout(
+              _vulkan.textureImages[target].images[image],
+              VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_UNDEFINED,
+              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+          copyBufferToImage(_vulkan.stagingBuffer,
+                            _vulkan.textureImages[target].images[image],
+                            static_cast<uint32_t>(_opts.ocean_tex_size),
+                            static_cast<uint32_t>(_opts.ocean_tex_size));
+          transitionImageLayout(_vulkan.textureImages[target].images[image],
+                                VK_FORMAT_R32G32B32A32_SFLOAT,
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
       }
     }
   } else {
@@ -84,16 +84,19 @@ protected:
     std::unique_ptr<cl::Image2D> dxyz_coef_mem[3];
     std::unique_ptr<cl::Image2D> hkt_pong_mem;
     std::unique_ptr<cl::Image2D> twiddle_factors_mem;
-    std::unique_ptr<cl::Image2D> h0k_mem;
-    std::unique_ptr<cl::Image2D> noise_mem;
+    std::unique_ptr<cl::Image2D> h0k_mem[MAX_CASCADES];
+    std::unique_ptr<cl::Image2D> noise_mem[MAX_CASCADES];
     std::unique_ptr<cl::Image2D> z_ranges_mem[2];
 
+    // last reduce_ranges level of every cascade read back by host
+    std::array<float, RANGE_LEVEL_FLOATS * MAX_CASCADES> range_levels{};
+
     size_t ocl_max_img2d_width=0;
     cl_ulong ocl_max_alloc_size=0, ocl_mem_size=0;
 
     // opencl-vulkan iteroperability resources
     // final computation result with displacements and normal map,
-    // needs to follow swap-chain scheme
+    // needs to follow swap-chain scheme, one set per cascade
     std::array<std::vector<std::unique_ptr<cl::Image2D>>, IOPT_COUNT> mems;
     std::vector<cl::Semaphore> signalSemaphores;
 
@@ -109,6 +112,43 @@ public:
 protected:
 
     void checkOpenCLExternalMemorySupport(cl::Device& device);
+
+    // z range of base cascade and displacement bound of all from range_levels
+    void readRangeLevels();
+
+    // devices of the OpenCL context, the simulation device by default
+    virtual std::vector<cl::Device> contextDevices(const std::vector<cl::Device>& devices);
+
+    // record-once pipeline per resource slot
+    bool useCommandBuffers() const { return enqueueCommandBufferKHR != nullptr; }
+
+    void loadCommandBufferFunctions(cl::Platform& platform);
+
+    void recordCommandBuffer(uint32_t currentImage);
+
+    void replayCommandBuffer(uint32_t currentImage, float elapsed);
+
+protected:
+
+    // cl_khr_command_buffer entry points, null if extension is not used
+    decltype(&clCreateCommandBufferKHR) createCommandBufferKHR = nullptr;
+    decltype(&clFinalizeCommandBufferKHR) finalizeCommandBufferKHR = nullptr;
+    decltype(&clCommandNDRangeKernelKHR) commandNDRangeKernelKHR = nullptr;
+    decltype(&clEnqueueCommandBufferKHR) enqueueCommandBufferKHR = nullptr;
+    decltype(&clReleaseCommandBufferKHR) releaseCommandBufferKHR = nullptr;
+
+    std::vector<cl_command_buffer_khr> command_buffers;
+
+    // recorded variants reading mutable state from device memory
+    cl::Kernel time_spectrum_cb_kernel;
+    cl::Kernel foam_cb_kernel;
+    cl::Kernel copy_cb_kernel;
+
+    std::unique_ptr<cl::Buffer> time_mem;
+    float cb_elapsed = 0.f;
+
+    // recorded copies of last reduce_ranges level of further cascades
+    std::unique_ptr<cl::Image2D> cascade_ranges_mem[MAX_CASCADES];
 };
 
 #endif //_WAVE_COMPUTE_LAYER_HPP_
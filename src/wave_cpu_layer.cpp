@@ -0,0 +1,711 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "wave_cpu_layer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#include <glm/gtc/constants.hpp>
+
+namespace {
+
+const float GRAVITY = 9.81f;
+
+glm::vec4 gaussRND(glm::vec4 rnd) {
+  rnd = glm::clamp(rnd, 0.001f, 1.f);
+  float u0 = 2.f * glm::pi<float>() * rnd.x;
+  float v0 = std::sqrt(-2.f * std::log(rnd.y));
+  float u1 = 2.f * glm::pi<float>() * rnd.z;
+  float v1 = std::sqrt(-2.f * std::log(rnd.w));
+  return glm::vec4(v0 * std::cos(u0), v0 * std::sin(u0), v1 * std::cos(u1),
+                   v1 * std::sin(u1));
+}
+
+float ipow(float x, int n) {
+  float r = 1.f;
+  for (int i = 0; i < n; i++)
+    r *= x;
+  return r;
+}
+
+// same as init_spectrum_phillips.cl
+glm::vec4 spectrumPhillips(glm::ivec2 uv, int patch, int res, glm::vec4 params,
+                   glm::vec4 rnd) {
+  glm::vec2 fuv = glm::vec2(uv) - glm::vec2((float)(res - 1) / 2.f);
+  glm::vec2 k = (2.f * glm::pi<float>() * fuv) / (float)patch;
+  float k_mag = glm::length(k);
+
+  float wind_speed = glm::length(glm::vec2(params));
+  glm::vec2 wind_norm = glm::vec2(params) / wind_speed;
+  float l_phl = (wind_speed * wind_speed) / GRAVITY;
+
+  float magSq = k_mag * k_mag;
+
+  float phillips = std::exp(-(1.f / (magSq * l_phl * l_phl)));
+  float amplitude = params.z / (magSq * magSq);
+  float f0 = std::sqrt(amplitude * phillips *
+                       std::exp(-magSq * params.w * params.w)) /
+             std::sqrt(2.f);
+
+  // directional distribution
+  float dp = glm::dot(glm::normalize(k), wind_norm);
+  float dm = glm::dot(glm::normalize(-k), wind_norm);
+
+  glm::vec4 gauss_random = gaussRND(rnd);
+  return glm::vec4(glm::vec2(gauss_random) * f0 * dp * dp,
+                   glm::vec2(gauss_random.z, gauss_random.w) * f0 * dm * dm);
+}
+
+float jonswap(float k, float kinv, float fp, float gamma, float alpha,
+              float beta) {
+  float sigma = (k <= fp) ? 0.07f : 0.09f;
+  float fdif = k - fp;
+  float r = std::exp(-(fdif * fdif) / (2.f * ipow(sigma * fp, 2)));
+  return alpha * ipow(kinv, 5) * std::exp(-beta * ipow(fp * kinv, 4)) *
+         std::pow(gamma, r);
+}
+
+// same as init_spectrum_jonswap.cl
+glm::vec4 spectrumJonswap(glm::ivec2 uv, int patch, int res, glm::vec4 params,
+                  glm::vec4 rnd) {
+  glm::vec2 fuv = glm::vec2(uv) - glm::vec2((float)(res - 1) / 2.f);
+  glm::vec2 k = (2.f * glm::pi<float>() * fuv) / (patch / 2.f);
+  glm::vec2 kinv = glm::vec2(1.f) / k;
+
+  glm::vec2 wind_norm = glm::vec2(params) / glm::length(glm::vec2(params));
+
+  float fp = 0.08f;
+  float gamma = 8.f;
+  float alpha = 0.06f;
+  float beta = 1.2f;
+  int spreading = 16;
+
+  float f0 = jonswap(k.x, kinv.x, fp, gamma, alpha, beta);
+  float f1 = jonswap(k.y, kinv.y, fp, gamma, alpha, beta);
+
+  // directional distribution
+  float dp = ipow(glm::dot(glm::normalize(k), wind_norm), spreading);
+  float dm = ipow(glm::dot(glm::normalize(-k), wind_norm), spreading);
+
+  glm::vec4 gauss_random = gaussRND(rnd);
+  return glm::vec4(gauss_random.x * f0 * dp, gauss_random.y * f1 * dp,
+                   gauss_random.z * f0 * dm, gauss_random.w * f1 * dm);
+}
+
+// Inverse FFT of a block of lines, element j of line b stored at
+// [j * lines + b] so the innermost loops stream over the lines and vectorize.
+// Stockham autosort with radix-4 stages and a final radix-2 one for odd
+// log2 of size, tw holds e^(2*pi*i*k/size). Result ends up in re/im.
+void fftLines(float *re, float *im, float *work_re, float *work_im,
+              size_t size, size_t lines, const float *tw_re,
+              const float *tw_im) {
+  float *xr = re, *xi = im, *yr = work_re, *yi = work_im;
+  size_t n = size, s = 1;
+
+  while (n > 1) {
+    size_t stride = size / n;
+    if (n % 4 == 0) {
+      size_t m = n / 4;
+      for (size_t p = 0; p < m; p++) {
+        float w1r = tw_re[p * stride], w1i = tw_im[p * stride];
+        float w2r = tw_re[2 * p * stride], w2i = tw_im[2 * p * stride];
+        float w3r = tw_re[3 * p * stride], w3i = tw_im[3 * p * stride];
+        for (size_t q = 0; q < s; q++) {
+          size_t i0 = (q + s * p) * lines, i1 = i0 + s * m * lines,
+                 i2 = i1 + s * m * lines, i3 = i2 + s * m * lines;
+          size_t o0 = (q + s * 4 * p) * lines, o1 = o0 + s * lines,
+                 o2 = o1 + s * lines, o3 = o2 + s * lines;
+          for (size_t b = 0; b < lines; b++) {
+            float apcr = xr[i0 + b] + xr[i2 + b], apci = xi[i0 + b] + xi[i2 + b];
+            float amcr = xr[i0 + b] - xr[i2 + b], amci = xi[i0 + b] - xi[i2 + b];
+            float bpdr = xr[i1 + b] + xr[i3 + b], bpdi = xi[i1 + b] + xi[i3 + b];
+            float bmdr = xr[i1 + b] - xr[i3 + b], bmdi = xi[i1 + b] - xi[i3 + b];
+
+            // inverse transform, i * (b - d) rotates by +90 degrees
+            float t1r = amcr - bmdi, t1i = amci + bmdr;
+            float t2r = apcr - bpdr, t2i = apci - bpdi;
+            float t3r = amcr + bmdi, t3i = amci - bmdr;
+
+            yr[o0 + b] = apcr + bpdr;
+            yi[o0 + b] = apci + bpdi;
+            yr[o1 + b] = t1r * w1r - t1i * w1i;
+            yi[o1 + b] = t1r * w1i + t1i * w1r;
+            yr[o2 + b] = t2r * w2r - t2i * w2i;
+            yi[o2 + b] = t2r * w2i + t2i * w2r;
+            yr[o3 + b] = t3r * w3r - t3i * w3i;
+            yi[o3 + b] = t3r * w3i + t3i * w3r;
+          }
+        }
+      }
+      n = m;
+      s *= 4;
+    } else {
+      // last stage of size 2, all twiddles equal 1
+      for (size_t q = 0; q < s; q++) {
+        size_t i0 = q * lines, i1 = i0 + s * lines;
+        for (size_t b = 0; b < lines; b++) {
+          float ar = xr[i0 + b], ai = xi[i0 + b];
+          float br = xr[i1 + b], bi = xi[i1 + b];
+          yr[i0 + b] = ar + br;
+          yi[i0 + b] = ai + bi;
+          yr[i1 + b] = ar - br;
+          yi[i1 + b] = ai - bi;
+        }
+      }
+      n = 1;
+      s *= 2;
+    }
+    std::swap(xr, yr);
+    std::swap(xi, yi);
+  }
+
+  if (xr != re) {
+    std::memcpy(re, xr, size * lines * sizeof(float));
+    std::memcpy(im, xi, size * lines * sizeof(float));
+  }
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+void WaveCPULayer::initCompute() {
+  // textures are filled from host memory, no interop
+  _opts.useExternalMemory = false;
+  _opts.linearImages = false;
+
+  if (_opts.technique == 0) {
+    _opts.alt_scale /= 2;
+  }
+
+  log_2_N = (size_t)((log((float)_opts.ocean_tex_size) / log(2.f)) - 1);
+  fft_size = size_t(1) << log_2_N;
+  fft_block = std::min(fft_block, fft_size);
+
+  printf("Running simulation on CPU, %zu threads.\n", pool.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool WaveCPULayer::useExternalMemoryType() { return false; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveCPULayer::initComputeResources() {
+  size_t texSize = _opts.ocean_tex_size;
+  size_t texels = texSize * texSize;
+
+  noise.resize(texels);
+  {
+    std::random_device dev;
+    std::mt19937 rng(dev());
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+
+    for (auto &n : noise)
+      n = {dist(rng), dist(rng), dist(rng), dist(rng)};
+  }
+
+  h0k.resize(fft_size * fft_size);
+  for (int i = 0; i < 3; i++) {
+    hkt_re[i].resize(fft_size * fft_size);
+    hkt_im[i].resize(fft_size * fft_size);
+  }
+  height.resize(texels);
+  height_corner.resize(texels);
+  nmap.assign(texels, glm::vec4(0.f));
+  row_ranges.resize(texSize);
+  row_bounds.resize(texSize);
+
+  initTwiddleFactors();
+
+  size_t imageCount = slotCount();
+  VkDeviceSize imageSize = texels * sizeof(glm::vec4);
+
+  for (size_t target = 0; target < IOPT_COUNT; target++) {
+    stagingBuffers[target].resize(imageCount);
+    stagingMemories[target].resize(imageCount);
+    stagingData[target].resize(imageCount);
+    for (size_t i = 0; i < imageCount; i++) {
+      createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                   stagingBuffers[target][i], stagingMemories[target][i]);
+      vkMapMemory(_vulkan.device, stagingMemories[target][i], 0, imageSize, 0,
+                  reinterpret_cast<void **>(&stagingData[target][i]));
+    }
+  }
+
+  // display textures start cleared since foam factor accumulates in normal
+  // map, later uploads discard previous content
+  {
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+    VkClearColorValue clearColor{};
+    VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    for (size_t target = 0; target < IOPT_COUNT; target++) {
+      for (auto image : _vulkan.textureImages[target].images) {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = range;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                             nullptr, 1, &barrier);
+
+        vkCmdClearColorImage(commandBuffer, image,
+                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor,
+                             1, &range);
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+      }
+    }
+
+    endSingleTimeCommands(commandBuffer);
+  }
+
+  VkCommandBufferAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.commandPool = _vulkan.commandPool;
+  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandBufferCount = static_cast<uint32_t>(imageCount);
+
+  uploadCommandBuffers.resize(imageCount);
+  if (vkAllocateCommandBuffers(_vulkan.device, &allocInfo,
+                               uploadCommandBuffers.data()) != VK_SUCCESS)
+    throw std::runtime_error("WaveCPULayer::initComputeResources: failed to "
+                             "allocate command buffers!");
+
+  for (uint32_t i = 0; i < imageCount; i++)
+    recordUploadCommands(i);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveCPULayer::recordUploadCommands(uint32_t currentImage) {
+  VkCommandBuffer commandBuffer = uploadCommandBuffers[currentImage];
+  uint32_t texSize = static_cast<uint32_t>(_opts.ocean_tex_size);
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+  if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    throw std::runtime_error("WaveCPULayer::recordUploadCommands: failed to "
+                             "begin recording command buffer!");
+
+  std::array<VkImageMemoryBarrier, IOPT_COUNT> barriers{};
+  for (size_t target = 0; target < IOPT_COUNT; target++) {
+    VkImageMemoryBarrier &barrier = barriers[target];
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = _vulkan.textureImages[target].images[currentImage];
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    // whole texture is overwritten, previous content may be discarded
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  }
+  vkCmdPipelineBarrier(commandBuffer,
+                       VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                           VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, static_cast<uint32_t>(barriers.size()),
+                       barriers.data());
+
+  VkBufferImageCopy region{};
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.layerCount = 1;
+  region.imageExtent = {texSize, texSize, 1};
+
+  for (size_t target = 0; target < IOPT_COUNT; target++)
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffers[target][currentImage],
+                           barriers[target].image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+  for (auto &barrier : barriers) {
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  }
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                           VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       0, 0, nullptr, 0, nullptr,
+                       static_cast<uint32_t>(barriers.size()),
+                       barriers.data());
+
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    throw std::runtime_error("WaveCPULayer::recordUploadCommands: failed to "
+                             "record command buffer!");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+VkCommandBuffer WaveCPULayer::computeCommandBuffer(uint32_t currentImage) {
+  return upload ? uploadCommandBuffers[currentImage] : VK_NULL_HANDLE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveCPULayer::initTwiddleFactors() {
+  twiddle_re.resize(fft_size);
+  twiddle_im.resize(fft_size);
+  for (size_t k = 0; k < fft_size; k++) {
+    double angle = 2.0 * glm::pi<double>() * (double)k / (double)fft_size;
+    twiddle_re[k] = (float)std::cos(angle);
+    twiddle_im[k] = (float)std::sin(angle);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveCPULayer::initSpectrum() {
+  float wind_angle_rad = glm::radians(_opts.wind_angle);
+  glm::vec4 params(_opts.wind_magnitude * glm::cos(wind_angle_rad),
+                   _opts.wind_magnitude * glm::sin(wind_angle_rad),
+                   _opts.amplitude, _opts.supress_factor);
+  int patch = (int)(_opts.ocean_grid_size * _opts.mesh_spacing);
+  int res = (int)_opts.ocean_tex_size;
+  auto spectrum =
+      _opts.technique == 0 ? spectrumPhillips : spectrumJonswap;
+
+  // only leading fft_size x fft_size texels take part in the FFT
+  pool.parallelFor(fft_size, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++)
+      for (size_t x = 0; x < fft_size; x++)
+        h0k[y * fft_size + x] = spectrum(glm::ivec2((int)x, (int)y), patch, res,
+                                         params, noise[y * res + x]);
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveCPULayer::timeSpectrum() {
+  int patch = (int)(_opts.ocean_grid_size * _opts.mesh_spacing);
+  int res = (int)_opts.ocean_tex_size;
+
+  pool.parallelFor(fft_size, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      for (size_t x = 0; x < fft_size; x++) {
+        size_t i = y * fft_size + x;
+        glm::vec2 wave_vec = glm::vec2((float)x, (float)y) -
+                             glm::vec2((float)(res - 1) / 2.f);
+        glm::vec2 k = (2.f * glm::pi<float>() * wave_vec) / (float)patch;
+        float k_mag = glm::length(k);
+
+        float w = std::sqrt(GRAVITY * k_mag);
+        float cos_wt = std::cos(w * elapsed);
+        float sin_wt = std::sin(w * elapsed);
+
+        // h0(k) * e^(iwt) + conj(h0(-k)) * e^(-iwt)
+        const glm::vec4 &h = h0k[i];
+        float dyr = h.x * cos_wt - h.y * sin_wt + h.z * cos_wt - h.w * sin_wt;
+        float dyi = h.x * sin_wt + h.y * cos_wt - h.z * sin_wt - h.w * cos_wt;
+
+        // dx, dz multiplied by -i * k / |k|
+        hkt_re[0][i] = dyi * k.x / k_mag;
+        hkt_im[0][i] = -dyr * k.x / k_mag;
+        hkt_re[1][i] = dyr;
+        hkt_im[1][i] = dyi;
+        hkt_re[2][i] = dyi * k.y / k_mag;
+        hkt_im[2][i] = -dyr * k.y / k_mag;
+      }
+    }
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveCPULayer::fft2D() {
+  const size_t size = fft_size, lines = fft_block;
+  const size_t blocks = size / lines;
+
+  // rows then columns, each task gathers a block of lines of one component
+  for (int dir = 0; dir < 2; dir++) {
+    // element j of line l at [l * line_stride + j * elem_stride]
+    size_t line_stride = dir == 0 ? size : 1;
+    size_t elem_stride = dir == 0 ? 1 : size;
+
+    pool.parallelFor(3 * blocks, [&](size_t begin, size_t end) {
+      std::vector<float> scratch(4 * size * lines);
+      float *blk_re = scratch.data();
+      float *blk_im = blk_re + size * lines;
+      float *work_re = blk_im + size * lines;
+      float *work_im = work_re + size * lines;
+
+      for (size_t task = begin; task < end; task++) {
+        float *re = hkt_re[task / blocks].data();
+        float *im = hkt_im[task / blocks].data();
+        size_t first = (task % blocks) * lines;
+
+        for (size_t j = 0; j < size; j++)
+          for (size_t b = 0; b < lines; b++) {
+            size_t src = (first + b) * line_stride + j * elem_stride;
+            blk_re[j * lines + b] = re[src];
+            blk_im[j * lines + b] = im[src];
+          }
+
+        fftLines(blk_re, blk_im, work_re, work_im, size, lines,
+                 twiddle_re.data(), twiddle_im.data());
+
+        for (size_t j = 0; j < size; j++)
+          for (size_t b = 0; b < lines; b++) {
+            size_t dst = (first + b) * line_stride + j * elem_stride;
+            re[dst] = blk_re[j * lines + b];
+            im[dst] = blk_im[j * lines + b];
+          }
+      }
+    });
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveCPULayer::inversion(glm::vec4 *dst) {
+  size_t texSize = _opts.ocean_tex_size;
+  size_t mask = fft_size - 1;
+  float res2 = (float)(texSize * texSize);
+
+  // last level of reduce_ranges pyramid holds texels of this stride
+  size_t range_stride = texSize >> log_2_N;
+
+  pool.parallelFor(texSize, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      const size_t row = (y & mask) * fft_size;
+      glm::vec2 bound(0.f);
+      for (size_t x = 0; x < texSize; x++) {
+        size_t i = row + (x & mask);
+        glm::vec4 d(hkt_re[0][i] / res2, hkt_re[1][i] / res2,
+                    hkt_re[2][i] / res2, 1.f);
+        dst[y * texSize + x] = d;
+        height[y * texSize + x] = d.y;
+        bound = glm::max(bound, glm::vec2(std::fabs(d.y),
+                                          std::max(std::fabs(d.x),
+                                                   std::fabs(d.z))));
+      }
+      row_bounds[y] = bound;
+
+      if (y % range_stride == 0) {
+        glm::vec2 range(height[y * texSize], height[y * texSize]);
+        for (size_t x = 0; x < texSize; x += range_stride) {
+          range.x = std::min(range.x, height[y * texSize + x]);
+          range.y = std::max(range.y, height[y * texSize + x]);
+        }
+        row_ranges[y] = range;
+      }
+    }
+  });
+
+  z_range = row_ranges[0];
+  for (size_t y = 0; y < texSize; y += range_stride) {
+    z_range.x = std::min(z_range.x, row_ranges[y].x);
+    z_range.y = std::max(z_range.y, row_ranges[y].y);
+  }
+
+  displ_bound = glm::vec2(0.f);
+  for (size_t y = 0; y < texSize; y++)
+    displ_bound = glm::max(displ_bound, row_bounds[y]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveCPULayer::normals() {
+  const size_t texSize = _opts.ocean_tex_size;
+  const size_t mask = texSize - 1;
+  const float normal_scale_fac = 3.f;
+
+  // linear filtered fetch at p / size lands on the corner shared by four
+  // texels, averages are computed once and reused by neighbours
+  pool.parallelFor(texSize, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      const float *row0 = &height[((y - 1) & mask) * texSize];
+      const float *row1 = &height[y * texSize];
+      for (size_t x = 0; x < texSize; x++) {
+        size_t x0 = (x - 1) & mask;
+        height_corner[y * texSize + x] =
+            0.25f * (row0[x0] + row0[x] + row1[x0] + row1[x]);
+      }
+    }
+  });
+
+  pool.parallelFor(texSize, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      const float *rb = &height_corner[((y - 1) & mask) * texSize];
+      const float *rc = &height_corner[y * texSize];
+      const float *rt = &height_corner[((y + 1) & mask) * texSize];
+      for (size_t x = 0; x < texSize; x++) {
+        size_t xl = (x - 1) & mask, xr = (x + 1) & mask;
+
+        glm::vec3 normal(0.f, 0.f, 1.f / normal_scale_fac);
+        normal.y = rc[x] + 2.f * rb[x] + rb[xr] - rt[xl] - 2.f * rt[x] - rt[xr];
+        normal.x = rc[x] + 2.f * rc[xl] + rt[xl] - rb[xr] - 2.f * rc[xr] - rt[xr];
+
+        glm::vec4 &n = nmap[y * texSize + x];
+        n = glm::vec4(glm::normalize(normal), n.w);
+      }
+    }
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveCPULayer::foam(glm::vec4 *dst) {
+  const size_t texSize = _opts.ocean_tex_size;
+  const size_t mask = texSize - 1;
+  const float delimiter = _opts.technique == 0 ? 2.f : 8.f;
+
+  auto corner = [&](size_t x, size_t y) {
+    size_t x0 = (x - 1) & mask, x1 = x & mask;
+    size_t y0 = (y - 1) & mask, y1 = y & mask;
+    return 0.25f * (glm::vec3(nmap[y0 * texSize + x0]) +
+                    glm::vec3(nmap[y0 * texSize + x1]) +
+                    glm::vec3(nmap[y1 * texSize + x0]) +
+                    glm::vec3(nmap[y1 * texSize + x1]));
+  };
+
+  // neighbours read only xyz of normals, foam factor is updated in place
+  pool.parallelFor(texSize, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      for (size_t x = 0; x < texSize; x++) {
+        size_t i = y * texSize + x;
+
+        glm::vec3 n0 = corner(x + 4, y);
+        glm::vec3 n1 = corner(x, y + 4);
+        glm::vec3 n2 = corner(x - 4, y);
+        glm::vec3 n3 = corner(x, y - 4);
+
+        float f0 = glm::clamp(std::fabs(glm::dot(n0, n2) * -0.5f + 0.5f), 0.f,
+                              1.f);
+        float f1 = glm::clamp(std::fabs(glm::dot(n1, n3) * -0.5f + 0.5f), 0.f,
+                              1.f);
+
+        f0 = (f0 * 8.f) * (f0 * 8.f);
+        f1 = (f1 * 8.f) * (f1 * 8.f);
+
+        float z_bias =
+            std::fabs((height[i] - z_range.x) / (z_range.y - z_range.x));
+
+        float foam_fac = noise[i].x * glm::clamp(std::max(f0, f1), 0.f, 1.f) *
+                         std::pow(z_bias, delimiter);
+
+        glm::vec4 &n = nmap[i];
+        n.w = std::max(foam_fac, n.w) - 0.001f;
+        dst[i] = n;
+      }
+    }
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveCPULayer::reportThroughput(float seconds) {
+  report_seconds += seconds;
+  report_frames++;
+
+  auto now = std::chrono::system_clock::now();
+  std::chrono::duration<float> delta = now - report_time;
+  if (delta.count() < 1.f)
+    return;
+
+  if (_opts.show_fps && report_seconds > 0.f) {
+    double texels = double(_opts.ocean_tex_size) * _opts.ocean_tex_size;
+    printf("CPU simulation: %.2f ms/frame, %.1f Mtexel/s, %zu threads\n",
+           1000.0 * report_seconds / report_frames,
+           texels * report_frames / report_seconds * 1e-6, pool.size());
+  }
+
+  report_time = now;
+  report_seconds = 0.f;
+  report_frames = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveCPULayer::updateSolver(uint32_t currentImage) {
+  // staging of this slot is rewritten below, drawFrame retired its last use
+  auto end = std::chrono::system_clock::now();
+
+  upload = _opts.animate;
+  if (_opts.animate) {
+    std::chrono::duration<float> delta = end - start;
+    elapsed = delta.count();
+
+    // twiddle factors depend on texture size only
+    _opts.twiddle_factors_init = false;
+
+    // change of some ocean's parameters requires to rebuild initial spectrum
+    if (_opts.changed) {
+      initSpectrum();
+      _opts.changed = false;
+    }
+
+    auto sim_start = std::chrono::system_clock::now();
+
+    timeSpectrum();
+    fft2D();
+    inversion(stagingData[IOPT_DISPLACEMENT][currentImage]);
+    normals();
+    foam(stagingData[IOPT_NORMAL_MAP][currentImage]);
+
+    std::chrono::duration<float> sim_time =
+        std::chrono::system_clock::now() - sim_start;
+    reportThroughput(sim_time.count());
+  } else {
+    // hold the animation at the same time point
+    std::chrono::duration<float> duration(elapsed);
+    start = end - std::chrono::duration_cast<std::chrono::seconds>(duration);
+  }
+
+  updateUniforms(currentImage);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveCPULayer::cleanup() {
+  for (size_t target = 0; target < IOPT_COUNT; target++) {
+    for (size_t i = 0; i < stagingBuffers[target].size(); i++) {
+      vkDestroyBuffer(_vulkan.device, stagingBuffers[target][i], nullptr);
+      vkFreeMemory(_vulkan.device, stagingMemories[target][i], nullptr);
+    }
+  }
+
+  // command buffers are released together with the pool
+  WaveVulkanLayer::cleanup();
+}
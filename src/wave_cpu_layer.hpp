@@ -0,0 +1,124 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _WAVE_CPU_LAYER_HPP_
+#define _WAVE_CPU_LAYER_HPP_
+
+#include "wave_util.hpp"
+#include "wave_render_layer.hpp"
+#include "wave_thread_pool.hpp"
+
+// whole simulation on host threads, for machines without OpenCL and as
+// reference of GPU kernels; results land in persistently mapped staging
+// buffers copied to textures ahead of rendering
+class WaveCPULayer : public WaveVulkanLayer {
+
+public:
+
+    WaveCPULayer(SharedOptions & opts) : WaveVulkanLayer(opts) {}
+
+    virtual void cleanup() override;
+
+    virtual void initCompute() override;
+
+    virtual void initComputeResources() override;
+
+    void updateSolver(uint32_t currentImage) override;
+
+    bool useExternalMemoryType() override;
+
+protected:
+
+    VkCommandBuffer computeCommandBuffer(uint32_t currentImage) override;
+
+protected:
+
+    void initTwiddleFactors();
+
+    void initSpectrum();
+
+    void timeSpectrum();
+
+    void fft2D();
+
+    void inversion(glm::vec4 * dst);
+
+    void normals();
+
+    void foam(glm::vec4 * dst);
+
+    void recordUploadCommands(uint32_t currentImage);
+
+    void reportThroughput(float seconds);
+
+protected:
+
+    WaveThreadPool pool;
+
+    // GPU pipelines transform 2^log_2_N leading samples of each line and
+    // repeat the result over the texture, FFT here has the same size
+    size_t log_2_N = 0;
+    size_t fft_size = 0;
+
+    // lines transformed together, inner loops run over lines of a block
+    size_t fft_block = 16;
+
+    std::vector<glm::vec4> noise;
+    std::vector<glm::vec4> h0k;
+    std::vector<float> twiddle_re;
+    std::vector<float> twiddle_im;
+
+    // dx, dy, dz spectra of fft_size x fft_size, transformed in place
+    std::array<std::vector<float>, 3> hkt_re;
+    std::array<std::vector<float>, 3> hkt_im;
+
+    // displacement y and its average at texel corners, full resolution
+    std::vector<float> height;
+    std::vector<float> height_corner;
+
+    // normals and foam factor kept between frames
+    std::vector<glm::vec4> nmap;
+
+    std::vector<glm::vec2> row_ranges;
+    // largest height and horizontal displacement of every row
+    std::vector<glm::vec2> row_bounds;
+
+    // per resource slot staging of each texture, persistently mapped
+    std::array<std::vector<VkBuffer>, IOPT_COUNT> stagingBuffers;
+    std::array<std::vector<VkDeviceMemory>, IOPT_COUNT> stagingMemories;
+    std::array<std::vector<glm::vec4 *>, IOPT_COUNT> stagingData;
+
+    std::vector<VkCommandBuffer> uploadCommandBuffers;
+
+    float elapsed = 0.f;
+
+    bool upload = false;
+
+    // simulation throughput reported once per second
+    std::chrono::system_clock::time_point report_time =
+        std::chrono::system_clock::now();
+    float report_seconds = 0.f;
+    size_t report_frames = 0;
+};
+
+#endif //_WAVE_CPU_LAYER_HPP_
@@ -29,6 +29,16 @@ SOFTWARE.
 #include <random>
 #include <set>
 
+std::vector<cl::Device> WaveOpenCLFoamLayer::contextDevices(const std::vector<cl::Device> & devices)
+{
+    std::vector<cl::Device> ctx_devices = WaveOpenCLLayer::contextDevices(devices);
+
+    // solver images migrate between devices of one context, no host staging
+    if (_opts.cfd_dev_index >= 0 && _opts.cfd_dev_index != _opts.dev_index)
+        ctx_devices.push_back(devices[_opts.cfd_dev_index]);
+    return ctx_devices;
+}
+
 void WaveOpenCLFoamLayer::initCompute()
 {
     WaveOpenCLLayer::initCompute();
@@ -52,13 +62,31 @@ void WaveOpenCLFoamLayer::initCompute()
     // recreate command queue with out-of-order property to parallelize IFFT and CFD computations
     commandQueue = cl::CommandQueue{ context, cl_device, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE };
 
-    auto build_opencl_kernel = [&](const char* src_file, cl::Kernel& kernel,
-                                   const char* name) {
+    // CFD solver either shares the ocean queue, gets its own in-order queue
+    // or runs on another device of the same platform and context
+    commandQueueFoam = commandQueue;
+    if (_opts.cfd_dev_index >= 0 && _opts.cfd_dev_index != _opts.dev_index)
+    {
+        printf("Running CFD solver on device: %s\n",
+               devices[_opts.cfd_dev_index]
+                   .getInfo<CL_DEVICE_NAME>()
+                   .c_str());
+
+        commandQueueFoam = cl::CommandQueue{ context, devices[_opts.cfd_dev_index] };
+    }
+    else if (_opts.cfd_queue || _opts.cfd_dev_index >= 0)
+    {
+        commandQueueFoam = cl::CommandQueue{ context, cl_device };
+    }
+
+    auto build_opencl_kernel = [&](const char* src_file, cl::Kernel& kernel, const char* name,
+                                   const std::string & options = std::string()) {
         try
         {
             std::string kernel_code = readFile(src_file).data();
             cl::Program program{ context, kernel_code };
-            program.build();
+            // CFD kernels share macros of kernels/cfd_tiles.h
+            program.build(("-I kernels " + options).c_str());
             kernel = cl::Kernel{ program, name };
         } catch (const cl::BuildError& e)
         {
@@ -71,11 +99,78 @@ void WaveOpenCLFoamLayer::initCompute()
     };
 
     build_opencl_kernel("kernels/copy_reduce.cl", copy_kernel, "copy_reduce");
-    build_opencl_kernel("kernels/advect.cl", advect_kernel, "advect");
-    build_opencl_kernel("kernels/divergence.cl", div_kernel, "divergence");
-    build_opencl_kernel("kernels/jacobi.cl", jacobi_kernel, "jacobi");
-    build_opencl_kernel("kernels/pressure.cl", pressure_kernel, "pressure");
     build_opencl_kernel("kernels/reduce_foam.cl", max_ranges_kernel, "reduce");
+
+    // sparse variants of CFD stages take the active tiles list as trailing arguments
+    std::string cfd_opts = _opts.cfd_active_tiles ? "-DACTIVE_TILES " : "";
+
+    // stages depending on time step read it from device buffer
+    std::string dt_opts = cfd_opts + (_opts.cfd_device_dt ? "-DDEVICE_DT " : "");
+
+    build_opencl_kernel("kernels/advect.cl", advect_kernel, "advect", dt_opts);
+    if (_opts.cfd_advection == 1)
+        build_opencl_kernel("kernels/advect.cl", maccormack_kernel, "maccormack", dt_opts);
+    build_opencl_kernel("kernels/divergence.cl", div_kernel, "divergence", cfd_opts);
+    build_opencl_kernel("kernels/jacobi.cl", jacobi_kernel, "jacobi", cfd_opts);
+    build_opencl_kernel("kernels/pressure.cl", pressure_kernel, "pressure", dt_opts);
+
+    if (_opts.cfd_device_dt)
+        build_opencl_kernel("kernels/reduce_foam.cl", cfl_kernel, "cfl_dt");
+
+    if (_opts.cfd_rate > 0.f)
+        build_opencl_kernel("kernels/foam_cfd.cl", blend_foam_kernel, "blend_foam");
+
+    if (_opts.cfd_active_tiles)
+    {
+        build_opencl_kernel("kernels/active_tiles.cl", tile_activity_kernel, "tile_activity");
+        build_opencl_kernel("kernels/active_tiles.cl", compact_tiles_kernel, "compact_tiles");
+    }
+
+    if (_opts.cfd_fused_kernels)
+    {
+        // local tiles of fused kernels are sized by work-group size
+        std::string tile_opts = cfd_opts + "-DTILE=" + std::to_string(_opts.group_size);
+        build_opencl_kernel("kernels/divergence_jacobi.cl", div_jacobi_kernel,
+                            "divergence_jacobi", tile_opts);
+        build_opencl_kernel("kernels/jacobi_pressure.cl", jacobi_pressure_kernel,
+                            "jacobi_pressure", tile_opts +
+                            (_opts.cfd_device_dt ? " -DDEVICE_DT" : ""));
+    }
+
+    if (_opts.jacobi_block_steps > 1)
+    {
+        // blocked kernel keeps three (TILE + 2 * STEPS)^2 float tiles in local memory
+        // and needs whole TILE x TILE work-group, limit STEPS to what CFD device holds
+        cl::Device cfd_device = commandQueueFoam.getInfo<CL_QUEUE_DEVICE>();
+        size_t local_mem = cfd_device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>();
+        size_t max_group = cfd_device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+
+        auto tile_bytes = [&](size_t steps) {
+            size_t ext = _opts.group_size + 2 * steps;
+            return 3 * ext * ext * sizeof(cl_float);
+        };
+
+        unsigned short steps = _opts.jacobi_block_steps;
+        if (_opts.group_size * _opts.group_size > max_group)
+            steps = 1;
+        while (steps > 1 && tile_bytes(steps) > local_mem)
+            steps--;
+
+        if (steps != _opts.jacobi_block_steps)
+        {
+            printf("Blocked Jacobi with %u steps exceeds CFD device limits, using %u steps.\n",
+                   _opts.jacobi_block_steps, steps);
+            _opts.jacobi_block_steps = steps;
+        }
+    }
+
+    if (_opts.jacobi_block_steps > 1)
+    {
+        std::string block_opts = cfd_opts + "-DTILE=" + std::to_string(_opts.group_size) +
+                                 " -DSTEPS=" + std::to_string(_opts.jacobi_block_steps);
+        build_opencl_kernel("kernels/jacobi_blocked.cl", jacobi_blocked_kernel,
+                            "jacobi_blocked", block_opts);
+    }
 }
 
 void WaveOpenCLFoamLayer::initComputeResources()
@@ -85,6 +180,13 @@ void WaveOpenCLFoamLayer::initComputeResources()
     size_t gwx = _opts.ocean_tex_size * _opts.foam_size_mult;
     size_t gwy = _opts.ocean_tex_size * _opts.foam_size_mult;
 
+    for (auto & pong : pong_mems)
+    {
+        pong = std::make_unique<cl::Image2D>(
+                    context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RG, CL_FLOAT),
+                    _opts.ocean_tex_size, _opts.ocean_tex_size);
+    }
+
     for ( int i=0; i<fld_cont.size(); i++)
     {
         fld_cont[i] = std::make_unique<cl::Image2D>(
@@ -94,6 +196,20 @@ void WaveOpenCLFoamLayer::initComputeResources()
         flds[i] = fld_cont[i].get();
     }
 
+    if (_opts.cfd_advection == 1)
+    {
+        advectTexture = std::make_unique<cl::Image2D>(
+                    context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_FLOAT),
+                    gwx, gwy);
+    }
+
+    if (_opts.cfd_rate > 0.f)
+    {
+        foamPrevTexture = std::make_unique<cl::Image2D>(
+                    context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_FLOAT),
+                    gwx, gwy);
+    }
+
     divRBTexture = std::make_unique<cl::Image2D>(
                 context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT),
                 gwx, gwy);
@@ -113,29 +229,45 @@ void WaveOpenCLFoamLayer::initComputeResources()
     max_ranges_mem[1] = std::make_unique<cl::Image2D>(
         context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT),
         gwx / 2, gwy / 2);
-}
 
-std::int16_t WaveOpenCLFoamLayer::getNextFromEventsCache()
-{
-    std::int16_t id=cache_counter;
-    cache_counter++;
-    if(id>=wait_evs_cache.size())
+    if (_opts.cfd_device_dt)
     {
-        wait_evs_cache.push_back(std::vector<cl::Event>());
+        dt_mem = std::make_unique<cl::Buffer>(context, CL_MEM_READ_WRITE, sizeof(cl_float));
+    }
+
+    if (_opts.cfd_active_tiles)
+    {
+        size_t tiles = (gwx / _opts.group_size) * (gwy / _opts.group_size);
+
+        tile_mask_mem = std::make_unique<cl::Buffer>(
+            context, CL_MEM_READ_WRITE, sizeof(cl_uchar) * tiles);
+
+        // dilated masks are kept for two frames, zero initialized
+        std::vector<cl_uchar> zeros(tiles, 0);
+        for (int i = 0; i < 2; i++)
+            tile_dilated_mem[i] = std::make_unique<cl::Buffer>(
+                context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                sizeof(cl_uchar) * tiles, zeros.data());
+
+        tile_list_mem = std::make_unique<cl::Buffer>(
+            context, CL_MEM_READ_WRITE, sizeof(cl_int2) * tiles);
+
+        tile_count_mem = std::make_unique<cl::Buffer>(
+            context, CL_MEM_READ_WRITE, sizeof(cl_int));
     }
-    wait_evs_cache[id].resize(1, cl::Event());
-    return id;
 }
 
-std::vector<cl::Event> * WaveOpenCLFoamLayer::getAddr(const std::int16_t id)
+void WaveOpenCLFoamLayer::setSolverTailArgs(cl::Kernel & kernel, cl_uint index, bool dt_arg)
 {
-    if(static_cast<unsigned>(id)>=wait_evs_cache.size())
+    if (_opts.cfd_active_tiles)
     {
-        return nullptr;
+        kernel.setArg(index++, *tile_list_mem);
+        kernel.setArg(index++, *tile_count_mem);
     }
-    return &wait_evs_cache[id];
-}
 
+    if (dt_arg && _opts.cfd_device_dt)
+        kernel.setArg(index, *dt_mem);
+}
 
 void WaveOpenCLFoamLayer::updateSimulation(uint32_t currentImage, float elapsed)
 {
@@ -147,6 +279,9 @@ void WaveOpenCLFoamLayer::updateSimulation(uint32_t currentImage, float elapsed)
         lws = cl::NDRange{ _opts.group_size, _opts.group_size };
     }
 
+    // previous frame is complete, start tracking from scratch
+    tasks.reset();
+
     if (_opts.twiddle_factors_init)
     {
         try
@@ -171,14 +306,10 @@ void WaveOpenCLFoamLayer::updateSimulation(uint32_t currentImage, float elapsed)
             twiddle_kernel.setArg(1, bit_reversed_inds_mem);
             twiddle_kernel.setArg(2, *twiddle_factors_mem);
 
-            auto evs = getAddr(getNextFromEventsCache());
-            commandQueue.enqueueNDRangeKernel(
-                twiddle_kernel, cl::NullRange,
-                cl::NDRange{log_2_N, _opts.ocean_tex_size}, cl::NDRange{1, 16},
-                nullptr, &evs->front());
+            tasks.kernel(commandQueue, twiddle_kernel,
+                         cl::NDRange{log_2_N, _opts.ocean_tex_size}, cl::NDRange{1, 16},
+                         { &bit_reversed_inds_mem }, { twiddle_factors_mem.get() });
             _opts.twiddle_factors_init = false;
-            cl::Event::waitForEvents(*evs);
-            cache_counter=0;
         } catch (const cl::Error &e) {
           printf("twiddle indices: OpenCL %s kernel error: %s\n", e.what(),
                  IGetErrorString(e.err()));
@@ -200,16 +331,16 @@ void WaveOpenCLFoamLayer::updateSimulation(uint32_t currentImage, float elapsed)
             };
             init_spectrum_kernel.setArg(0, patch);
             init_spectrum_kernel.setArg(1, params);
-            init_spectrum_kernel.setArg(2, *noise_mem);
-            init_spectrum_kernel.setArg(3, *h0k_mem);
+            init_spectrum_kernel.setArg(2, *noise_mem[0]);
+            init_spectrum_kernel.setArg(3, *h0k_mem[0]);
+
+            // foam layer runs single cascade covering the whole spectrum
+            glm::vec2 band = cascade_band(_opts, 0);
+            init_spectrum_kernel.setArg(4, cl_float2{ band.x, band.y });
 
-            auto evs = getAddr(getNextFromEventsCache());
-            commandQueue.enqueueNDRangeKernel(
-                init_spectrum_kernel, cl::NullRange,
-                cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws,
-                nullptr, &evs->front());
-            cl::Event::waitForEvents(*evs);
-            cache_counter=0;
+            tasks.kernel(commandQueue, init_spectrum_kernel,
+                         cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws,
+                         { noise_mem[0].get() }, { h0k_mem[0].get() });
 
             _opts.changed = false;
         } catch (const cl::Error& e)
@@ -219,103 +350,80 @@ void WaveOpenCLFoamLayer::updateSimulation(uint32_t currentImage, float elapsed)
         }
     }
 
-    std::int16_t swp_evts[2] = {-1, getNextFromEventsCache()};
-
     // ping-pong phase spectrum kernel launch
     try
     {
         time_spectrum_kernel.setArg(0, elapsed);
         time_spectrum_kernel.setArg(1, patch);
-        time_spectrum_kernel.setArg(2, *h0k_mem);
+        time_spectrum_kernel.setArg(2, *h0k_mem[0]);
         time_spectrum_kernel.setArg(3, *dxyz_coef_mem[0]);
         time_spectrum_kernel.setArg(4, *dxyz_coef_mem[1]);
         time_spectrum_kernel.setArg(5, *dxyz_coef_mem[2]);
 
-        commandQueue.enqueueNDRangeKernel(
-            time_spectrum_kernel, cl::NullRange,
-            cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws,
-            getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
-
-        std::swap(swp_evts[0], swp_evts[1]);
-        swp_evts[1] = getNextFromEventsCache();
+        tasks.kernel(commandQueue, time_spectrum_kernel,
+                     cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws,
+                     { h0k_mem[0].get() },
+                     { dxyz_coef_mem[0].get(), dxyz_coef_mem[1].get(), dxyz_coef_mem[2].get() });
     } catch (const cl::Error &e) {
       printf("updateSimulation: OpenCL %s kernel error: %s\n", e.what(),
              IGetErrorString(e.err()));
       exit(1);
     }
 
-    // perform 1D FFT horizontal and vertical iterations
+    // perform 1D FFT horizontal and vertical iterations,
+    // each channel has its own pong image so channels overlap
     size_t log_2_N = (size_t)((log((float)_opts.ocean_tex_size) / log(2.f))-1);
     fft_kernel.setArg(1, patch);
     fft_kernel.setArg(2, *twiddle_factors_mem);
     for ( cl_int i=0; i<3; i++)
     {
-        const cl::Image * displ_swap[] = {dxyz_coef_mem[i].get(), hkt_pong_mem.get()};
+        const cl::Image * displ_swap[] = {dxyz_coef_mem[i].get(), pong_mems[i].get()};
         cl_int2 mode = (cl_int2){0, 0};
 
         bool ifft_pingpong=false;
         for (int p = 0; p < log_2_N; p++)
         {
-            if (ifft_pingpong)
-            {
-                fft_kernel.setArg(3, *displ_swap[1]);
-                fft_kernel.setArg(4, *displ_swap[0]);
-            }
-            else
-            {
-                fft_kernel.setArg(3, *displ_swap[0]);
-                fft_kernel.setArg(4, *displ_swap[1]);
-            }
+            int src = ifft_pingpong ? 1 : 0;
+            fft_kernel.setArg(3, *displ_swap[src]);
+            fft_kernel.setArg(4, *displ_swap[1 - src]);
 
             mode.s[1] = p;
             fft_kernel.setArg(0, mode);
 
-            commandQueue.enqueueNDRangeKernel(
-                fft_kernel, cl::NullRange,
-                cl::NDRange{ _opts.ocean_tex_size, _opts.ocean_tex_size }, lws,
-                        getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
+            tasks.kernel(commandQueue, fft_kernel,
+                         cl::NDRange{ _opts.ocean_tex_size, _opts.ocean_tex_size }, lws,
+                         { twiddle_factors_mem.get(), displ_swap[src] }, { displ_swap[1 - src] });
 
             ifft_pingpong = !ifft_pingpong;
-            std::swap(swp_evts[0], swp_evts[1]);
-            swp_evts[1] = getNextFromEventsCache();
         }
 
         // Cols
         mode.s[0] = 1;
         for (int p = 0; p < log_2_N; p++)
         {
-            if (ifft_pingpong)
-            {
-                fft_kernel.setArg(3, *displ_swap[1]);
-                fft_kernel.setArg(4, *displ_swap[0]);
-            }
-            else
-            {
-                fft_kernel.setArg(3, *displ_swap[0]);
-                fft_kernel.setArg(4, *displ_swap[1]);
-            }
+            int src = ifft_pingpong ? 1 : 0;
+            fft_kernel.setArg(3, *displ_swap[src]);
+            fft_kernel.setArg(4, *displ_swap[1 - src]);
 
             mode.s[1] = p;
             fft_kernel.setArg(0, mode);
 
-            commandQueue.enqueueNDRangeKernel(
-                fft_kernel, cl::NullRange,
-                cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws,
-                getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
+            tasks.kernel(commandQueue, fft_kernel,
+                         cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws,
+                         { twiddle_factors_mem.get(), displ_swap[src] }, { displ_swap[1 - src] });
 
             ifft_pingpong = !ifft_pingpong;
-            std::swap(swp_evts[0], swp_evts[1]);
-            swp_evts[1] = getNextFromEventsCache();
         }
 
         if (log_2_N%2)
         {
             // swap images if pingpong hold on temporary buffer
             std::array<size_t, 3> orig = {0,0,0}, region={_opts.ocean_tex_size, _opts.ocean_tex_size, 1};
-            commandQueue.enqueueCopyImage(*displ_swap[0], *displ_swap[1], orig, orig, region,
-                    getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
-            std::swap(swp_evts[0], swp_evts[1]);
-            swp_evts[1] = getNextFromEventsCache();
+            tasks.submit({ displ_swap[0] }, { displ_swap[1] },
+                         [&](const std::vector<cl::Event> * wait, cl::Event * done) {
+                             commandQueue.enqueueCopyImage(*displ_swap[0], *displ_swap[1], orig,
+                                                           orig, region, wait, done);
+                         });
         }
     }
 
@@ -323,11 +431,11 @@ void WaveOpenCLFoamLayer::updateSimulation(uint32_t currentImage, float elapsed)
     {
         for (size_t target=0; target<IOPT_COUNT; target++)
         {
-          commandQueue.enqueueAcquireExternalMemObjects(
-              {*mems[target][currentImage]}, getAddr(swp_evts[0]),
-              &getAddr(swp_evts[1])->front());
-          std::swap(swp_evts[0], swp_evts[1]);
-          swp_evts[1] = getNextFromEventsCache();
+            const cl::Image2D * mem = mems[target][currentImage].get();
+            tasks.submit({}, { mem },
+                         [&](const std::vector<cl::Event> * wait, cl::Event * done) {
+                             commandQueue.enqueueAcquireExternalMemObjects({ *mem }, wait, done);
+                         });
         }
     }
 
@@ -340,15 +448,14 @@ void WaveOpenCLFoamLayer::updateSimulation(uint32_t currentImage, float elapsed)
         inversion_kernel.setArg(4, *mems[IOPT_DISPLACEMENT][currentImage]);
         inversion_kernel.setArg(5, *z_ranges_mem[0]);
 
-        commandQueue.enqueueNDRangeKernel(
-            inversion_kernel, cl::NullRange,
-            cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws,
-            getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
-        std::swap(swp_evts[0], swp_evts[1]);
-        swp_evts[1] = getNextFromEventsCache();
+        tasks.kernel(commandQueue, inversion_kernel,
+                     cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws,
+                     { dxyz_coef_mem[0].get(), dxyz_coef_mem[1].get(), dxyz_coef_mem[2].get() },
+                     { mems[IOPT_DISPLACEMENT][currentImage].get(), z_ranges_mem[0].get() });
     }
 
-    // min max reduction
+    // min max reduction, result is read back asynchronously and resolved
+    // only when foam kernel needs it
     {
         cl::NDRange lws = cl::NDRange{ _opts.group_size, _opts.group_size };
         cl_int2 patch = cl_int2{ (int)_opts.ocean_tex_size/2, (int)_opts.ocean_tex_size/2 };
@@ -358,26 +465,24 @@ void WaveOpenCLFoamLayer::updateSimulation(uint32_t currentImage, float elapsed)
             z_ranges_kernel.setArg(1, *z_ranges_mem[p%2]);
             z_ranges_kernel.setArg(2, *z_ranges_mem[(p+1)%2]);
 
-            commandQueue.enqueueNDRangeKernel(
-                z_ranges_kernel, cl::NullRange,
-                cl::NDRange{ (cl::size_type)patch.x, (cl::size_type)patch.y }, lws,
-                        getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
+            tasks.kernel(commandQueue, z_ranges_kernel,
+                         cl::NDRange{ (cl::size_type)patch.x, (cl::size_type)patch.y }, lws,
+                         { z_ranges_mem[p%2].get() }, { z_ranges_mem[(p+1)%2].get() });
 
             patch = cl_int2{ patch.x/2, patch.y/2 };
             if (patch.x<lws.get()[0])
                 lws = cl::NDRange{ (cl::size_type)patch.x, (cl::size_type)patch.y };
-
-            std::swap(swp_evts[0], swp_evts[1]);
-            swp_evts[1] = getNextFromEventsCache();
         }
-        float buf[2] = {0,0};
-        commandQueue.enqueueReadImage(
-            *z_ranges_mem[log_2_N%2], true, cl::array<cl::size_type, 2>{ 0, 0 },
-            cl::array<cl::size_type, 2>{ 1, 1 }, 0, 0, buf,
-                    getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
-        z_range = glm::vec2(buf[0], buf[1]);
-        std::swap(swp_evts[0], swp_evts[1]);
-        swp_evts[1] = getNextFromEventsCache();
+
+        z_range_src = z_ranges_mem[log_2_N%2].get();
+        tasks.submit({ z_range_src }, {},
+                     [&](const std::vector<cl::Event> * wait, cl::Event * done) {
+                         commandQueue.enqueueReadImage(
+                             *z_range_src, false, cl::array<cl::size_type, 2>{ 0, 0 },
+                             cl::array<cl::size_type, 2>{ RANGE_LEVEL_SIZE, RANGE_LEVEL_SIZE },
+                             0, 0, range_levels.data(), wait, done);
+                     });
+        z_range_pending = true;
     }
 
     // normals computation
@@ -387,24 +492,43 @@ void WaveOpenCLFoamLayer::updateSimulation(uint32_t currentImage, float elapsed)
         normals_kernel.setArg(2, *mems[IOPT_NORMAL_MAP][currentImage]);
         normals_kernel.setArg(3, *mems[IOPT_NORMAL_MAP][currentImage]);
 
-        commandQueue.enqueueNDRangeKernel(
-            normals_kernel, cl::NullRange,
-            cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws,
-            getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
-
-        final_events = swp_evts[1];
+        tasks.kernel(commandQueue, normals_kernel,
+                     cl::NDRange{_opts.ocean_tex_size, _opts.ocean_tex_size}, lws,
+                     { mems[IOPT_DISPLACEMENT][currentImage].get(),
+                       mems[IOPT_NORMAL_MAP][currentImage].get() },
+                     { mems[IOPT_NORMAL_MAP][currentImage].get() });
     }
 
     computeFoam(currentImage, patch);
 
+    resolveZRange();
+
     if (_opts.useExternalMemory)
     {
         for (size_t target=0; target<IOPT_COUNT; target++)
         {
-            commandQueue.enqueueReleaseExternalMemObjects(
-                { *mems[target][currentImage] });
+            const cl::Image2D * mem = mems[target][currentImage].get();
+            tasks.submit({}, { mem },
+                         [&](const std::vector<cl::Event> * wait, cl::Event * done) {
+                             commandQueue.enqueueReleaseExternalMemObjects({ *mem }, wait, done);
+                         });
         }
     }
+    else
+    {
+        // results are mapped afterwards without wait lists
+        commandQueue.enqueueBarrierWithWaitList();
+    }
+}
+
+void WaveOpenCLFoamLayer::resolveZRange()
+{
+    if (!z_range_pending)
+        return;
+
+    tasks.wait({ z_range_src });
+    readRangeLevels();
+    z_range_pending = false;
 }
 
 void WaveOpenCLFoamLayer::setupFoamSolver(const std::string & name)
@@ -424,50 +548,114 @@ void WaveOpenCLFoamLayer::computeFoam(const uint32_t currentImage, const cl_int2
     size_t gwx = _opts.ocean_tex_size * _opts.foam_size_mult;
     size_t gwy = _opts.ocean_tex_size * _opts.foam_size_mult;
 
-    std::int16_t swp_evts[2] = {-1, getNextFromEventsCache()};
-
     if (!initialize_foam)
     {
         initialize_foam=true;
 
-        auto evs = getAddr(swp_evts[1]);
         // clear simulation buffers
         std::array<cl::size_type, 2> origin = { 0, 0 };
         std::array<cl::size_type, 2> region = { gwx, gwy };
-        for ( int i=0; i<fld_cont.size(); i++)
+        for (cl::Image2D * img : { fld_cont[0].get(), fld_cont[1].get(), divRBTexture.get(),
+                                   pressureRBTexture[0].get(), pressureRBTexture[1].get() })
+        {
+            tasks.submit({}, { img },
+                         [&](const std::vector<cl::Event> * wait, cl::Event * done) {
+                             commandQueueFoam.enqueueFillImage(
+                                 *img, cl_float4{ { 0.f, 0.f, 0.f, 0.f } },
+                                 origin, region, wait, done);
+                         });
+        }
+
+        // previous density is only used by blend kernel on the ocean queue
+        if (foamPrevTexture)
+        {
+            tasks.submit({}, { foamPrevTexture.get() },
+                         [&](const std::vector<cl::Event> * wait, cl::Event * done) {
+                             commandQueue.enqueueFillImage(
+                                 *foamPrevTexture, cl_float4{ { 0.f, 0.f, 0.f, 0.f } },
+                                 origin, region, wait, done);
+                         });
+        }
+    }
+
+
+    if (_opts.cfd_rate <= 0.f)
+    {
+        stepFoam(currentImage, patch, delta_time, 1.f);
+        return;
+    }
+
+    // fixed rate CFD, catch up with substeps and drop time beyond the limit
+    float step_time = 1.f / _opts.cfd_rate;
+    cfd_accum += delta_time;
+    int steps = (int)(cfd_accum / step_time);
+    if (steps > _opts.cfd_max_substeps)
+    {
+        steps = _opts.cfd_max_substeps;
+        // dropped time leaves one step, the capped frame blends up to the
+        // field computed last instead of the previous one
+        cfd_accum = step_time;
+    }
+    else
+    {
+        cfd_accum -= steps * step_time;
+    }
+
+    for (int s = 0; s < steps; s++)
+    {
+        if (s == steps - 1)
         {
-            commandQueue.enqueueFillImage(
-                *fld_cont[i], cl_float4{ { 0.f, 0.f, 0.f, 0.f } }, origin,
-                region, nullptr, &evs->back());
-            evs->push_back(cl::Event());
+            // keep density of previous step for interpolation
+            std::array<size_t, 3> orig = {0,0,0}, region={gwx, gwy, 1};
+            tasks.submit({ flds[FREAD] }, { foamPrevTexture.get() },
+                         [&](const std::vector<cl::Event> * wait, cl::Event * done) {
+                             commandQueue.enqueueCopyImage(*flds[FREAD], *foamPrevTexture,
+                                                           orig, orig, region, wait, done);
+                         });
         }
 
-        commandQueue.enqueueFillImage(*divRBTexture,
-                                      cl_float4{ { 0.f, 0.f, 0.f, 0.f } },
-                                      origin, region, nullptr, &evs->back());
-        evs->push_back(cl::Event());
-        commandQueue.enqueueFillImage(*pressureRBTexture[0],
-                                      cl_float4{ { 0.f, 0.f, 0.f, 0.f } },
-                                      origin, region, nullptr, &evs->back());
-                                      evs->push_back(cl::Event());
-        commandQueue.enqueueFillImage(*pressureRBTexture[1],
-                                      cl_float4{ { 0.f, 0.f, 0.f, 0.f } },
-                                      origin, region, nullptr, &evs->back());
-        cl::Event::waitForEvents(*evs);
+        stepFoam(currentImage, patch, step_time, 0.f);
+    }
+
+    // visual foam interpolated between last two CFD steps
+    {
+        blend_foam_kernel.setArg(0, cl_float4{ cfd_accum / step_time, delta_time,
+                                               (float)_opts.foam_size_mult, 0.f });
+        blend_foam_kernel.setArg(1, *foamPrevTexture);
+        blend_foam_kernel.setArg(2, *flds[FREAD]);
+        blend_foam_kernel.setArg(3, *mems[IOPT_NORMAL_MAP][currentImage]);
+        blend_foam_kernel.setArg(4, *mems[IOPT_NORMAL_MAP][currentImage]);
+
+        tasks.kernel(commandQueue, blend_foam_kernel,
+                     cl::NDRange{ _opts.ocean_tex_size, _opts.ocean_tex_size }, lws,
+                     { foamPrevTexture.get(), flds[FREAD],
+                       mems[IOPT_NORMAL_MAP][currentImage].get() },
+                     { mems[IOPT_NORMAL_MAP][currentImage].get() });
+    }
+}
+
+void WaveOpenCLFoamLayer::stepFoam(const uint32_t currentImage, const cl_int2 & patch,
+                                   float step_time, float visual)
+{
+    cl::NDRange lws {16, 16}; // NullRange by default.
+    if (_opts.group_size > 0)
+    {
+        lws = cl::NDRange{ _opts.group_size, _opts.group_size };
     }
 
+    size_t gwx = _opts.ocean_tex_size * _opts.foam_size_mult;
+    size_t gwy = _opts.ocean_tex_size * _opts.foam_size_mult;
+
+    cl::CommandQueue & queue = commandQueueFoam;
 
-    float dt=delta_time;
+    float dt=step_time;
     // min max reduction
     {
         // first copy velocities to reduction buffer
         copy_kernel.setArg(0, *flds[FREAD]);
         copy_kernel.setArg(1, *max_ranges_mem[0]);
-        commandQueue.enqueueNDRangeKernel(copy_kernel, cl::NullRange,
-                                          cl::NDRange{ gwx, gwy }, lws,
-                                          getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
-        std::swap(swp_evts[0], swp_evts[1]);
-        swp_evts[1] = getNextFromEventsCache();
+        tasks.kernel(queue, copy_kernel, cl::NDRange{ gwx, gwy }, lws,
+                     { flds[FREAD] }, { max_ranges_mem[0].get() });
 
         size_t log_2_N = (size_t) (log(gwx)/log(2.f));
         cl::NDRange rlws = cl::NDRange{ lws[0], lws[1] };
@@ -478,98 +666,203 @@ void WaveOpenCLFoamLayer::computeFoam(const uint32_t currentImage, const cl_int2
             max_ranges_kernel.setArg(1, *max_ranges_mem[p%2]);
             max_ranges_kernel.setArg(2, *max_ranges_mem[(p+1)%2]);
 
-            commandQueue.enqueueNDRangeKernel(
-                max_ranges_kernel, cl::NullRange,
-                cl::NDRange{ (cl::size_type)patch.x, (cl::size_type)patch.y }, rlws,
-                        getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
+            tasks.kernel(queue, max_ranges_kernel,
+                         cl::NDRange{ (cl::size_type)patch.x, (cl::size_type)patch.y }, rlws,
+                         { max_ranges_mem[p%2].get() }, { max_ranges_mem[(p+1)%2].get() });
 
             patch = cl_int2{ patch.x/2, patch.y/2 };
             if (patch.x<rlws.get()[0])
                 rlws = cl::NDRange{ (cl::size_type)patch.x, (cl::size_type)patch.y };
-
-            std::swap(swp_evts[0], swp_evts[1]);
-            swp_evts[1] = getNextFromEventsCache();
         }
-        float buf[2] = {0,0};
-        commandQueue.enqueueReadImage(
-            *max_ranges_mem[log_2_N%2], true, cl::array<cl::size_type, 2>{ 0, 0 },
-            cl::array<cl::size_type, 2>{ 1, 1 }, 0, 0, buf,
-                    getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
-
-        std::swap(swp_evts[0], swp_evts[1]);
-        swp_evts[1] = getNextFromEventsCache();
 
-        float vMax = buf[0];
+        const cl::Image2D * vmax_mem = max_ranges_mem[log_2_N%2].get();
+        if (_opts.cfd_device_dt)
+        {
+            // time step stays on device, no host synchronization
+            cfl_kernel.setArg(0, dt);
+            cfl_kernel.setArg(1, *vmax_mem);
+            cfl_kernel.setArg(2, *dt_mem);
+            tasks.kernel(queue, cfl_kernel, cl::NDRange{ 1 }, cl::NullRange,
+                         { vmax_mem }, { dt_mem.get() });
+        }
+        else
+        {
+            float buf[2] = {0,0};
+            tasks.submit({ vmax_mem }, {},
+                         [&](const std::vector<cl::Event> * wait, cl::Event * done) {
+                             queue.enqueueReadImage(
+                                 *vmax_mem, true, cl::array<cl::size_type, 2>{ 0, 0 },
+                                 cl::array<cl::size_type, 2>{ 1, 1 }, 0, 0, buf, wait, done);
+                         });
+
+            float vMax = buf[0];
+
+            if (vMax > 1e-10f&&!std::isnan(vMax))
+                dt = 0.95f / vMax;
+        }
+    }
 
-        if (vMax > 1e-10f&&!std::isnan(vMax))
-            dt = 0.95f / vMax;
+    // rebuild list of tiles touched by CFD stages, dispatch sizes stay dense
+    // and work-groups beyond the list length exit immediately
+    if (_opts.cfd_active_tiles)
+    {
+        cl_int2 tiles = cl_int2{ (int)(gwx / lws[0]), (int)(gwy / lws[1]) };
+
+        tasks.submit({}, { tile_count_mem.get() },
+                     [&](const std::vector<cl::Event> * wait, cl::Event * done) {
+                         queue.enqueueFillBuffer(*tile_count_mem, cl_int(0), 0, sizeof(cl_int),
+                                                 wait, done);
+                     });
+
+        tile_activity_kernel.setArg(0, _opts.cfd_tile_threshold);
+        tile_activity_kernel.setArg(1, *flds[FREAD]);
+        tile_activity_kernel.setArg(2, *tile_mask_mem);
+        tasks.kernel(queue, tile_activity_kernel, cl::NDRange{ gwx, gwy }, lws,
+                     { flds[FREAD] }, { tile_mask_mem.get() });
+
+        compact_tiles_kernel.setArg(0, tiles);
+        compact_tiles_kernel.setArg(1, *tile_mask_mem);
+        compact_tiles_kernel.setArg(2, *tile_dilated_mem[tile_history]);
+        compact_tiles_kernel.setArg(3, *tile_dilated_mem[1 - tile_history]);
+        compact_tiles_kernel.setArg(4, *tile_list_mem);
+        compact_tiles_kernel.setArg(5, *tile_count_mem);
+        tasks.kernel(queue, compact_tiles_kernel,
+                     cl::NDRange{ (cl::size_type)tiles.x, (cl::size_type)tiles.y }, cl::NullRange,
+                     { tile_mask_mem.get(), tile_dilated_mem[tile_history].get() },
+                     { tile_dilated_mem[1 - tile_history].get(), tile_list_mem.get(),
+                       tile_count_mem.get() });
+
+        tile_history = 1 - tile_history;
     }
 
+    // objects read by solver stages besides their images
+    const cl::Memory * tile_list = _opts.cfd_active_tiles ? tile_list_mem.get() : nullptr;
+    const cl::Memory * tile_count = _opts.cfd_active_tiles ? tile_count_mem.get() : nullptr;
+    const cl::Memory * dt_buf = _opts.cfd_device_dt ? dt_mem.get() : nullptr;
+    auto solver_reads = [&](std::initializer_list<const cl::Memory *> images) {
+        WaveTaskGraph::Deps reads(images);
+        for (auto obj : { tile_list, tile_count, dt_buf })
+            if (obj)
+                reads.push_back(obj);
+        return reads;
+    };
+
     // Advection phase
     {
-        advect_kernel.setArg(0, (cl_float4){ (float)gwx, (float)gwy, dt, 0.5f }); // damping
+        bool maccormack = _opts.cfd_advection == 1;
+        cl_float4 advect_info = cl_float4{ (float)gwx, (float)gwy, dt, 0.5f }; // damping
+        cl::Image2D * advect_dst = maccormack ? advectTexture.get() : flds[1];
+
+        advect_kernel.setArg(0, advect_info);
         advect_kernel.setArg(1, *flds[FREAD]);
         advect_kernel.setArg(2, *flds[0]); // field read
-        advect_kernel.setArg(3, *flds[1]); // field wright
-        commandQueue.enqueueNDRangeKernel(advect_kernel, cl::NullRange,
-                                          cl::NDRange{gwx, gwy}, lws,
-                                          getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
+        // MacCormack corrects forward trace stored in intermediate image
+        advect_kernel.setArg(3, *advect_dst); // field wright
+        setSolverTailArgs(advect_kernel, 4, true);
+        enqueueSolverStage(advect_kernel, solver_reads({ flds[FREAD], flds[0] }), { advect_dst });
 
-        std::swap(swp_evts[0], swp_evts[1]);
-        swp_evts[1] = getNextFromEventsCache();
+        if (maccormack)
+        {
+            maccormack_kernel.setArg(0, advect_info);
+            maccormack_kernel.setArg(1, *flds[FREAD]);
+            maccormack_kernel.setArg(2, *flds[0]);
+            maccormack_kernel.setArg(3, *advectTexture);
+            maccormack_kernel.setArg(4, *flds[1]);
+            setSolverTailArgs(maccormack_kernel, 5, true);
+            enqueueSolverStage(maccormack_kernel,
+                               solver_reads({ flds[FREAD], flds[0], advectTexture.get() }),
+                               { flds[1] });
+        }
 
         std::swap(flds[0], flds[1]);
     }
 
     cl_float4 info = cl_float4 { (float)gwx, (float)gwy, dt, mcRevert };
 
+    // pressure ping-pong parity is carried over to the next step's warm start
+    cl_int PREAD = pressure_read, PWRITE = 1 - pressure_read;
+    cl_int jacobiIterations = _opts.jacobi_iterations;
+
+    // first and last relaxation sweeps are folded into neighbour stages
+    bool fused = _opts.cfd_fused_kernels && jacobiIterations >= 2;
+
     // Jacobi phase
+    if (fused)
+    {
+        div_jacobi_kernel.setArg(0, info);
+        div_jacobi_kernel.setArg(1, *flds[FREAD]);
+        div_jacobi_kernel.setArg(2, *pressureRBTexture[PREAD]);
+        div_jacobi_kernel.setArg(3, *divRBTexture);
+        div_jacobi_kernel.setArg(4, *pressureRBTexture[PWRITE]);
+        setSolverTailArgs(div_jacobi_kernel, 5);
+        enqueueSolverStage(div_jacobi_kernel,
+                           solver_reads({ flds[FREAD], pressureRBTexture[PREAD].get() }),
+                           { divRBTexture.get(), pressureRBTexture[PWRITE].get() });
+
+        std::swap(PREAD, PWRITE);
+
+        jacobiIterations -= 2;
+    }
+    else
     {
         div_kernel.setArg(0, info);
         div_kernel.setArg(1, *flds[FREAD]);
         div_kernel.setArg(2, *divRBTexture);
-        commandQueue.enqueueNDRangeKernel(div_kernel, cl::NullRange,
-                                          cl::NDRange{ gwx, gwy }, lws,
-                                          getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
-
-        std::swap(swp_evts[0], swp_evts[1]);
-        swp_evts[1] = getNextFromEventsCache();
+        setSolverTailArgs(div_kernel, 3);
+        enqueueSolverStage(div_kernel, solver_reads({ flds[FREAD] }), { divRBTexture.get() });
     }
 
-    cl_int PREAD = 0, PWRITE = 1;
-    cl_int jacobiIterations=20;
-    jacobi_kernel.setArg(0, info);
-    jacobi_kernel.setArg(1, *divRBTexture);
-    for(unsigned i = 0; i < jacobiIterations; ++i)
+    // temporally blocked launches perform several sweeps at once,
+    // remaining sweeps go through the plain kernel
+    cl_int blockSteps = _opts.jacobi_block_steps;
+    for(cl_int i = 0; i < jacobiIterations; )
     {
-        jacobi_kernel.setArg(2, *pressureRBTexture[PREAD]);
-        jacobi_kernel.setArg(3, *pressureRBTexture[PWRITE]);
-        commandQueue.enqueueNDRangeKernel(jacobi_kernel, cl::NullRange,
-                                          cl::NDRange{ gwx, gwy }, lws,
-                                          getAddr(swp_evts[0]), &getAddr(swp_evts[1])->front());
+        bool blocked = blockSteps > 1 && jacobiIterations - i >= blockSteps;
+        cl::Kernel & kernel = blocked ? jacobi_blocked_kernel : jacobi_kernel;
+
+        kernel.setArg(0, info);
+        kernel.setArg(1, *divRBTexture);
+        kernel.setArg(2, *pressureRBTexture[PREAD]);
+        kernel.setArg(3, *pressureRBTexture[PWRITE]);
+        setSolverTailArgs(kernel, 4);
+        enqueueSolverStage(kernel,
+                           solver_reads({ divRBTexture.get(), pressureRBTexture[PREAD].get() }),
+                           { pressureRBTexture[PWRITE].get() });
+        i += blocked ? blockSteps : 1;
         std::swap(PREAD, PWRITE);
-        std::swap(swp_evts[0], swp_evts[1]);
-        swp_evts[1] = getNextFromEventsCache();
     }
 
+    if (fused)
+    {
+        jacobi_pressure_kernel.setArg(0, info);
+        jacobi_pressure_kernel.setArg(1, *divRBTexture);
+        jacobi_pressure_kernel.setArg(2, *pressureRBTexture[PREAD]);
+        jacobi_pressure_kernel.setArg(3, *flds[FREAD]);
+        jacobi_pressure_kernel.setArg(4, *pressureRBTexture[PWRITE]);
+        jacobi_pressure_kernel.setArg(5, *flds[FWRITE]);
+        setSolverTailArgs(jacobi_pressure_kernel, 6, true);
+        enqueueSolverStage(jacobi_pressure_kernel,
+                           solver_reads({ divRBTexture.get(), pressureRBTexture[PREAD].get(),
+                                          flds[FREAD] }),
+                           { pressureRBTexture[PWRITE].get(), flds[FWRITE] });
+        std::swap(PREAD, PWRITE);
+    }
+    else
     {
-        auto fevs = getAddr(final_events);
-        if (!fevs)
-            fevs = getAddr(swp_evts[1]);
-        fevs->push_back(cl::Event());
         pressure_kernel.setArg(0, info);
         pressure_kernel.setArg(1, *pressureRBTexture[PREAD]);
         pressure_kernel.setArg(2, *flds[FREAD]);
         pressure_kernel.setArg(3, *flds[FWRITE]);
-        commandQueue.enqueueNDRangeKernel(pressure_kernel, cl::NullRange,
-                                          cl::NDRange{ gwx, gwy }, lws,
-                                          getAddr(swp_evts[0]), &fevs->back());
-        std::swap(flds[FREAD], flds[FWRITE]);
+        setSolverTailArgs(pressure_kernel, 4, true);
+        enqueueSolverStage(pressure_kernel,
+                           solver_reads({ pressureRBTexture[PREAD].get(), flds[FREAD] }),
+                           { flds[FWRITE] });
     }
+    std::swap(flds[FREAD], flds[FWRITE]);
 
+    pressure_read = PREAD;
 
-    cache_counter=0;
-
+    resolveZRange();
 
     float wind_angle_rad = glm::radians(_opts.wind_angle);
 
@@ -578,25 +871,41 @@ void WaveOpenCLFoamLayer::computeFoam(const uint32_t currentImage, const cl_int2
                              _opts.technique == 0 ? 2.f : 8.f,
                              _opts.wind_magnitude * glm::cos(wind_angle_rad),
                              _opts.wind_magnitude * glm::sin(wind_angle_rad),
-                             delta_time,
-                             10.f,
+                             step_time,
+                             visual,
                              (float)_opts.foam_size_mult};
 
 
     {
-        auto fevs = getAddr(final_events);
         foam_kernel.setArg(0, patch);
         foam_kernel.setArg(1, zr);
-        foam_kernel.setArg(2, *noise_mem);
+        foam_kernel.setArg(2, *noise_mem[0]);
         foam_kernel.setArg(3, *mems[IOPT_DISPLACEMENT][currentImage]);
         foam_kernel.setArg(4, *flds[FREAD]);
         foam_kernel.setArg(5, *mems[IOPT_NORMAL_MAP][currentImage]);
         foam_kernel.setArg(6, *flds[FREAD]);
         foam_kernel.setArg(7, *mems[IOPT_NORMAL_MAP][currentImage]);
 
-        commandQueue.enqueueNDRangeKernel(
-            foam_kernel, cl::NullRange,
-            cl::NDRange{ _opts.ocean_tex_size, _opts.ocean_tex_size }, lws, fevs, nullptr);
+        tasks.kernel(commandQueue, foam_kernel,
+                     cl::NDRange{ _opts.ocean_tex_size, _opts.ocean_tex_size }, lws,
+                     { noise_mem[0].get(), mems[IOPT_DISPLACEMENT][currentImage].get(),
+                       flds[FREAD], mems[IOPT_NORMAL_MAP][currentImage].get() },
+                     { flds[FREAD], mems[IOPT_NORMAL_MAP][currentImage].get() });
     }
 }
 
+void WaveOpenCLFoamLayer::enqueueSolverStage(const cl::Kernel & kernel,
+                                             const WaveTaskGraph::Deps & reads,
+                                             const WaveTaskGraph::Deps & writes)
+{
+    size_t gwx = _opts.ocean_tex_size * _opts.foam_size_mult;
+    size_t gwy = _opts.ocean_tex_size * _opts.foam_size_mult;
+    cl::NDRange lws = cl::NDRange{ _opts.group_size, _opts.group_size };
+
+    tasks.submit(reads, writes,
+                 [&](const std::vector<cl::Event> * wait, cl::Event * done) {
+                     commandQueueFoam.enqueueNDRangeKernel(kernel, cl::NullRange,
+                                                           cl::NDRange{ gwx, gwy }, lws,
+                                                           wait, done);
+                 });
+}
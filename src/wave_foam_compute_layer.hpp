@@ -26,6 +26,7 @@ SOFTWARE.
 
 #include "wave_util.hpp"
 #include "wave_compute_layer.hpp"
+#include "wave_task_graph.hpp"
 
 class WaveOpenCLFoamLayer : public WaveOpenCLLayer {
 
@@ -49,40 +50,92 @@ public:
 
 protected:
 
+    // separate CFD device joins the context of the simulation device
+    std::vector<cl::Device> contextDevices(const std::vector<cl::Device> & devices) override;
+
     void updateAdvection(float dt, float dumping, cl::Image2D & velocity, cl::Image2D ** fields );
 
-    std::int16_t getNextFromEventsCache();
+    // trailing arguments of solver kernels built with ACTIVE_TILES/DEVICE_DT
+    void setSolverTailArgs(cl::Kernel & kernel, cl_uint index, bool dt_arg = false);
+
+    // single CFD step followed by foam injection, visual weights normal map update
+    void stepFoam(const uint32_t currentImage, const cl_int2 & patch,
+                  float step_time, float visual);
 
-    std::vector<cl::Event> * getAddr(const std::int16_t id);
+    // full grid solver kernel launch on the CFD queue
+    void enqueueSolverStage(const cl::Kernel & kernel, const WaveTaskGraph::Deps & reads,
+                            const WaveTaskGraph::Deps & writes);
+
+    // wait for asynchronous z range readback
+    void resolveZRange();
 
 protected:
 
-    cl::Context contextFoam;
+    // CFD solver queue, the ocean queue unless dedicated one requested
     cl::CommandQueue commandQueueFoam;
 
     // Navier-Stokes fluid resources
     cl::Kernel copy_kernel;
     cl::Kernel advect_kernel;
+    cl::Kernel maccormack_kernel;
+    cl::Kernel blend_foam_kernel;
     cl::Kernel div_kernel;
     cl::Kernel jacobi_kernel;
     cl::Kernel pressure_kernel;
     cl::Kernel max_ranges_kernel;
+    cl::Kernel cfl_kernel;
+
+    // fused variants of the pressure solver stages
+    cl::Kernel div_jacobi_kernel;
+    cl::Kernel jacobi_pressure_kernel;
+
+    // several Jacobi sweeps per launch with local memory halos
+    cl::Kernel jacobi_blocked_kernel;
+
+    // activity mask and compacted list of tiles processed by CFD stages
+    cl::Kernel tile_activity_kernel;
+    cl::Kernel compact_tiles_kernel;
 
     std::array<std::unique_ptr<cl::Image2D>, 2> fld_cont;
 
     cl::Image2D* flds[2];
 
-    std::int16_t cache_counter=0;
-    std::vector<std::vector<cl::Event>>  wait_evs_cache;
-    std::int16_t final_events=-1;
+    // dependencies of ocean and CFD stages, queues of both devices share
+    // the context so events order them across devices
+    WaveTaskGraph tasks;
+
+    // IFFT pong image per channel, channels don't serialize on shared storage
+    std::array<std::unique_ptr<cl::Image2D>, 3> pong_mems;
+
+    const cl::Image2D * z_range_src = nullptr;
+    bool z_range_pending = false;
+
+    // density of the previous fixed rate CFD step
+    std::unique_ptr<cl::Image2D> foamPrevTexture;
+
+    // intermediate result of MacCormack advection
+    std::unique_ptr<cl::Image2D> advectTexture;
 
     std::unique_ptr<cl::Image2D> divRBTexture;
     std::unique_ptr<cl::Image2D> pressureRBTexture[2];
 
     std::unique_ptr<cl::Image2D> max_ranges_mem[2];
 
+    // CFL time step computed on device
+    std::unique_ptr<cl::Buffer> dt_mem;
+
+    std::unique_ptr<cl::Buffer> tile_mask_mem;
+    std::unique_ptr<cl::Buffer> tile_dilated_mem[2];
+    std::unique_ptr<cl::Buffer> tile_list_mem;
+    std::unique_ptr<cl::Buffer> tile_count_mem;
+
     cl_float mcRevert=0.05f;
     cl_int FREAD = 0, FWRITE = 1;
+    cl_int pressure_read = 0;
+    cl_int tile_history = 0;
+
+    // simulation time not yet consumed by fixed rate CFD steps
+    float cfd_accum = 0.f;
 
     bool initialize_foam=false;
 
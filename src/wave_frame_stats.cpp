@@ -0,0 +1,184 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "wave_frame_stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+////////////////////////////////////////////////////////////////////////////////
+
+WaveFrameStats::WaveFrameStats(size_t window, float bin_ms, size_t bins)
+    : window(std::max<size_t>(window, 1)), bin_ms(bin_ms), bins(bins)
+{
+    for (size_t channel = 0; channel < FS_COUNT; channel++)
+    {
+        history[channel].assign(this->window, 0.f);
+        histograms[channel].assign(bins + 1, 0);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char * WaveFrameStats::name(Channel channel)
+{
+    static const char * names[FS_COUNT] = {"frame", "cpu", "solver", "gpu",
+                                           "fence"};
+    return names[channel];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t WaveFrameStats::binOf(float ms) const
+{
+    if (!(ms > 0.f))
+        return 0;
+    return std::min(static_cast<size_t>(ms / bin_ms), bins);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveFrameStats::add(Channel channel, float ms)
+{
+    current[channel] += ms;
+    updated[channel] = true;
+    reported[channel] = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveFrameStats::set(Channel channel, float ms)
+{
+    current[channel] = ms;
+    updated[channel] = true;
+    reported[channel] = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveFrameStats::endFrame()
+{
+    for (size_t channel = 0; channel < FS_COUNT; channel++)
+    {
+        if (!updated[channel])
+            continue;
+
+        // oldest sample leaves the window once it is full
+        size_t & head = heads[channel];
+        if (counts[channel] == window)
+            histograms[channel][binOf(history[channel][head])]--;
+
+        history[channel][head] = current[channel];
+        histograms[channel][binOf(current[channel])]++;
+        head = (head + 1) % window;
+        counts[channel] = std::min(counts[channel] + 1, window);
+    }
+
+    // channels missing from the frame are left empty
+    if (csv.is_open())
+    {
+        csv << frame_index;
+        for (size_t channel = 0; channel < FS_COUNT; channel++)
+        {
+            csv << ",";
+            if (updated[channel])
+                csv << current[channel];
+        }
+        csv << "\n";
+    }
+
+    current.fill(0.f);
+    updated.fill(false);
+    count = std::min(count + 1, window);
+    frame_index++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+float WaveFrameStats::percentile(Channel channel, float p) const
+{
+    size_t samples = counts[channel];
+    if (samples == 0)
+        return 0.f;
+
+    // rank of the sample, then the bin which reaches it
+    size_t rank = static_cast<size_t>(
+        std::ceil(std::min(std::max(p, 0.f), 1.f) * samples));
+    rank = std::max<size_t>(rank, 1);
+
+    size_t seen = 0;
+    for (size_t bin = 0; bin <= bins; bin++)
+    {
+        seen += histograms[channel][bin];
+        if (seen >= rank)
+            return (bin + 1) * bin_ms;
+    }
+    return bins * bin_ms;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool WaveFrameStats::openCsv(const std::string & path)
+{
+    csv.open(path, std::ios::out | std::ios::trunc);
+    if (!csv.is_open())
+        return false;
+
+    csv << "frame_index";
+    for (size_t channel = 0; channel < FS_COUNT; channel++)
+        csv << "," << name(static_cast<Channel>(channel)) << "_ms";
+    csv << "\n";
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveFrameStats::flush()
+{
+    if (csv.is_open())
+        csv.flush();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::string WaveFrameStats::summary() const
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+
+    for (size_t channel = 0; channel < FS_COUNT; channel++)
+    {
+        if (!reported[channel])
+            continue;
+
+        Channel ch = static_cast<Channel>(channel);
+        if (ss.tellp() > 0)
+            ss << " | ";
+        ss << name(ch) << " " << percentile(ch, 0.5f) << "/"
+           << percentile(ch, 0.99f) << "/" << percentile(ch, 1.f);
+    }
+    ss << " ms (p50/p99/max)";
+    return ss.str();
+}
@@ -0,0 +1,103 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _WAVE_FRAME_STATS_HPP_
+#define _WAVE_FRAME_STATS_HPP_
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Per-frame timings over a rolling window of frames. Every channel keeps a
+// histogram updated as samples enter and leave the window, so percentiles
+// are available at any time without sorting. Frames which did not report a
+// channel add no sample to it, e.g. GPU time before the first readback.
+class WaveFrameStats {
+
+public:
+
+    enum Channel {
+        FS_FRAME = 0, // interval between consecutive frames
+        FS_CPU,       // host time of a frame, without blocking and pacing
+        FS_SOLVER,    // simulation update, OpenCL work is waited for
+        FS_GPU,       // Vulkan graphics work measured on device
+        FS_FENCE,     // host blocked on frame, image and slot fences
+        FS_COUNT
+    };
+
+    // window length in frames, histograms cover bins * bin_ms milliseconds
+    explicit WaveFrameStats(size_t window = 1024, float bin_ms = 0.05f,
+                            size_t bins = 4000);
+
+    // accumulated within a frame until endFrame
+    void add(Channel channel, float ms);
+
+    // replaces value of the frame, for channels measured as a whole
+    void set(Channel channel, float ms);
+
+    // moves reported channels of the frame into the window and CSV stream
+    void endFrame();
+
+    // p from [0, 1], resolution of the histogram bin
+    float percentile(Channel channel, float p) const;
+
+    size_t frames() const { return count; }
+
+    // rows of finished frames are streamed to the file, see flush
+    bool openCsv(const std::string & path);
+
+    void flush();
+
+    // p50/p99/max of reported channels in a single line
+    std::string summary() const;
+
+    static const char * name(Channel channel);
+
+private:
+
+    size_t binOf(float ms) const;
+
+    size_t window;
+    float bin_ms;
+    size_t bins;
+
+    std::array<float, FS_COUNT> current{};
+    // channels reported in the current frame and in any frame so far
+    std::array<bool, FS_COUNT> updated{};
+    std::array<bool, FS_COUNT> reported{};
+
+    // ring of last window samples per channel, histograms have extra
+    // overflow bin
+    std::array<std::vector<float>, FS_COUNT> history;
+    std::array<std::vector<uint32_t>, FS_COUNT> histograms;
+    std::array<size_t, FS_COUNT> heads{};
+    std::array<size_t, FS_COUNT> counts{};
+    size_t count = 0;
+    uint64_t frame_index = 0;
+
+    std::ofstream csv;
+};
+
+#endif //_WAVE_FRAME_STATS_HPP_
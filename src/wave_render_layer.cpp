@@ -30,10 +30,12 @@ SOFTWARE.
 #include "wave_render_layer.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <random>
 #include <set>
+#include <thread>
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -41,6 +43,13 @@ void WaveVulkanLayer::init(GLFWwindow *window) {
   initCompute();
   initVulkan(window);
   initComputeResources();
+
+  if (!_opts.stats_csv.empty() && !_stats.openCsv(_opts.stats_csv))
+    printf("Unable to open %s, frame statistics are not exported.\n",
+           _opts.stats_csv.c_str());
+
+  // first frame interval must not include initialization
+  _lastFrameTime = std::chrono::steady_clock::now();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -55,6 +64,7 @@ void WaveVulkanLayer::initVulkan(GLFWwindow *window) {
   createSurface(window);
   pickPhysicalDevice();
   createLogicalDevice();
+  createPipelineCache();
   createSwapChain();
   createImageViews();
   createRenderPass();
@@ -62,12 +72,15 @@ void WaveVulkanLayer::initVulkan(GLFWwindow *window) {
   createDescriptorSetLayout();
   createGraphicsPipeline();
   createCommandPool();
+  createTimestampPool();
 
   createDepthResources();
   createVertexBuffers();
   createIndexBuffers();
+  createIndirectBuffers();
 
   createFramebuffers();
+  createSceneTarget();
   createTextureImages();
   createTextureImageViews();
   createTextureSampler();
@@ -80,26 +93,20 @@ void WaveVulkanLayer::initVulkan(GLFWwindow *window) {
 ////////////////////////////////////////////////////////////////////////////////
 
 void WaveVulkanLayer::cleanup() {
-  vkDestroyImageView(_vulkan.device, _vulkan.depthImageView, nullptr);
-  vkDestroyImage(_vulkan.device, _vulkan.depthImage, nullptr);
-  vkFreeMemory(_vulkan.device, _vulkan.depthImageMemory, nullptr);
+  cleanupSwapChain();
 
-  for (auto framebuffer : _vulkan.swapChainFramebuffers) {
-    vkDestroyFramebuffer(_vulkan.device, framebuffer, nullptr);
+  for (auto pipeline : _vulkan.pipelines) {
+    vkDestroyPipeline(_vulkan.device, pipeline, nullptr);
   }
-
-  vkDestroyPipeline(_vulkan.device, _vulkan.graphicsPipeline, nullptr);
-  vkDestroyPipeline(_vulkan.device, _vulkan.wireframePipeline, nullptr);
   vkDestroyPipelineLayout(_vulkan.device, _vulkan.pipelineLayout, nullptr);
   vkDestroyRenderPass(_vulkan.device, _vulkan.renderPass, nullptr);
+  vkDestroyRenderPass(_vulkan.device, _vulkan.sceneRenderPass, nullptr);
 
-  for (auto imageView : _vulkan.swapChainImageViews) {
-    vkDestroyImageView(_vulkan.device, imageView, nullptr);
-  }
-
-  vkDestroySwapchainKHR(_vulkan.device, _vulkan.swapChain, nullptr);
   vkDestroyDescriptorPool(_vulkan.device, _vulkan.descriptorPool, nullptr);
 
+  if (_vulkan.timestampPool != VK_NULL_HANDLE)
+    vkDestroyQueryPool(_vulkan.device, _vulkan.timestampPool, nullptr);
+
   vkDestroyBuffer(_vulkan.device, _vulkan.stagingBuffer, nullptr);
   vkFreeMemory(_vulkan.device, _vulkan.stagingBufferMemory, nullptr);
 
@@ -114,6 +121,16 @@ void WaveVulkanLayer::cleanup() {
          _vulkan.textureImages[img_num].imageMemories) {
       vkFreeMemory(_vulkan.device, textureImageMemory, nullptr);
     }
+    for (auto mipImageView : _vulkan.textureImages[img_num].mipImageViews) {
+      vkDestroyImageView(_vulkan.device, mipImageView, nullptr);
+    }
+    for (auto mipImage : _vulkan.textureImages[img_num].mipImages) {
+      vkDestroyImage(_vulkan.device, mipImage, nullptr);
+    }
+    for (auto mipImageMemory :
+         _vulkan.textureImages[img_num].mipImageMemories) {
+      vkFreeMemory(_vulkan.device, mipImageMemory, nullptr);
+    }
   }
 
   for (size_t sampler_num = 0; sampler_num < _vulkan.textureSampler.size();
@@ -122,26 +139,20 @@ void WaveVulkanLayer::cleanup() {
                      nullptr);
   }
 
-  // cleanup vertices buffers
-  for (auto buffer : _vulkan.vertexBuffers) {
-    vkDestroyBuffer(_vulkan.device, buffer, nullptr);
-  }
+  // cleanup vertices and indices buffers
+  vkDestroyBuffer(_vulkan.device, _vulkan.vertexBuffer, nullptr);
+  vkFreeMemory(_vulkan.device, _vulkan.vertexBufferMemory, nullptr);
 
-  for (auto bufferMemory : _vulkan.vertexBufferMemories) {
-    vkFreeMemory(_vulkan.device, bufferMemory, nullptr);
-  }
+  vkDestroyBuffer(_vulkan.device, _vulkan.indexBuffer, nullptr);
+  vkFreeMemory(_vulkan.device, _vulkan.indexBufferMemory, nullptr);
 
-  // cleanup indices buffers
-  for (auto & ind_buffer : _vulkan.indexBuffers) {
-    for (auto & buffer : ind_buffer.buffers) {
-      vkDestroyBuffer(_vulkan.device, buffer, nullptr);
-    }
+  // cleanup indirect draw buffers
+  for (auto buffer : _vulkan.indirectBuffers) {
+    vkDestroyBuffer(_vulkan.device, buffer, nullptr);
   }
 
-  for (auto & ind_buffer : _vulkan.indexBuffers) {
-    for (auto & bufferMemory : ind_buffer.bufferMemories) {
-      vkFreeMemory(_vulkan.device, bufferMemory, nullptr);
-    }
+  for (auto bufferMemory : _vulkan.indirectBufferMemories) {
+    vkFreeMemory(_vulkan.device, bufferMemory, nullptr);
   }
 
   for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
@@ -165,6 +176,9 @@ void WaveVulkanLayer::cleanup() {
 
   vkDestroyCommandPool(_vulkan.device, _vulkan.commandPool, nullptr);
 
+  savePipelineCache();
+  vkDestroyPipelineCache(_vulkan.device, _vulkan.pipelineCache, nullptr);
+
   vkDestroyDevice(_vulkan.device, nullptr);
 
   if (gEnableValidationLayers) {
@@ -178,6 +192,64 @@ void WaveVulkanLayer::cleanup() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void WaveVulkanLayer::cleanupSwapChain() {
+  vkDestroyImageView(_vulkan.device, _vulkan.depthImageView, nullptr);
+  vkDestroyImage(_vulkan.device, _vulkan.depthImage, nullptr);
+  vkFreeMemory(_vulkan.device, _vulkan.depthImageMemory, nullptr);
+
+  if (_vulkan.sceneImage != VK_NULL_HANDLE) {
+    vkDestroyFramebuffer(_vulkan.device, _vulkan.sceneFramebuffer, nullptr);
+    vkDestroyImageView(_vulkan.device, _vulkan.sceneImageView, nullptr);
+    vkDestroyImage(_vulkan.device, _vulkan.sceneImage, nullptr);
+    vkFreeMemory(_vulkan.device, _vulkan.sceneImageMemory, nullptr);
+    _vulkan.sceneImage = VK_NULL_HANDLE;
+  }
+
+  for (auto framebuffer : _vulkan.swapChainFramebuffers) {
+    vkDestroyFramebuffer(_vulkan.device, framebuffer, nullptr);
+  }
+
+  for (auto &commandBuffers : _vulkan.commandBuffers) {
+    if (!commandBuffers.empty())
+      vkFreeCommandBuffers(_vulkan.device, _vulkan.commandPool,
+                           static_cast<uint32_t>(commandBuffers.size()),
+                           commandBuffers.data());
+    commandBuffers.clear();
+  }
+
+  for (auto imageView : _vulkan.swapChainImageViews) {
+    vkDestroyImageView(_vulkan.device, imageView, nullptr);
+  }
+
+  vkDestroySwapchainKHR(_vulkan.device, _vulkan.swapChain, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanLayer::recreateSwapChain() {
+  // minimized window has no extent to present into, main loop waits for it
+  if (_opts.window_width == 0 || _opts.window_height == 0)
+    return;
+
+  vkDeviceWaitIdle(_vulkan.device);
+  _opts.resized = false;
+
+  // resources of the slot ring stay, new image count only affects
+  // framebuffers and command buffers
+  cleanupSwapChain();
+  createSwapChain();
+  createImageViews();
+  createDepthResources();
+  createFramebuffers();
+  createSceneTarget();
+  createCommandBuffers();
+
+  _vulkan.imagesInFlight.assign(_vulkan.swapChainImages.size(),
+                                VK_NULL_HANDLE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void WaveVulkanLayer::createInstance() {
   if (gEnableValidationLayers && !checkValidationLayerSupport())
     throw std::runtime_error(
@@ -367,6 +439,31 @@ void WaveVulkanLayer::createLogicalDevice() {
 
   VkPhysicalDeviceFeatures deviceFeatures{};
   deviceFeatures.fillModeNonSolid = true;
+  // ocean shaders loop over cascade texture arrays
+  deviceFeatures.shaderSampledImageArrayDynamicIndexing = true;
+
+  // visible tiles are drawn with a single indirect call when supported
+  VkPhysicalDeviceFeatures supportedFeatures{};
+  vkGetPhysicalDeviceFeatures(_vulkan.physicalDevice, &supportedFeatures);
+  deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+  _vulkan.multiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+
+  if (_opts.tessellation && !supportedFeatures.tessellationShader) {
+    printf("Tessellation shaders are not supported by the device, using "
+           "regular mesh.\n");
+    _opts.tessellation = false;
+  }
+  deviceFeatures.tessellationShader = _opts.tessellation;
+
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(_vulkan.physicalDevice, &properties);
+  _vulkan.maxTessellationLevel =
+      (float)properties.limits.maxTessellationGenerationLevel;
+
+  // grazing views of mipmapped ocean textures benefit from anisotropy
+  deviceFeatures.samplerAnisotropy = supportedFeatures.samplerAnisotropy;
+  if (supportedFeatures.samplerAnisotropy)
+    _vulkan.maxSamplerAnisotropy = properties.limits.maxSamplerAnisotropy;
 
   VkDeviceCreateInfo createInfo{};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -402,6 +499,86 @@ void WaveVulkanLayer::createLogicalDevice() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void WaveVulkanLayer::createPipelineCache() {
+  std::vector<char> data;
+  if (!_opts.pipeline_cache.empty()) {
+    std::ifstream file(_opts.pipeline_cache, std::ios::ate | std::ios::binary);
+    if (file.is_open()) {
+      data.resize((size_t)file.tellg());
+      file.seekg(0);
+      file.read(data.data(), data.size());
+    }
+  }
+
+  // VK_PIPELINE_CACHE_HEADER_VERSION_ONE layout, data of another driver or
+  // device is dropped and the cache is rebuilt from scratch
+  struct {
+    uint32_t headerSize;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+  } header{};
+
+  if (data.size() >= sizeof(header)) {
+    memcpy(&header, data.data(), sizeof(header));
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(_vulkan.physicalDevice, &properties);
+
+    if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        header.vendorID != properties.vendorID ||
+        header.deviceID != properties.deviceID ||
+        memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID,
+               VK_UUID_SIZE)) {
+      printf("Pipeline cache %s does not match the device, rebuilding.\n",
+             _opts.pipeline_cache.c_str());
+      data.clear();
+    }
+  } else {
+    data.clear();
+  }
+
+  VkPipelineCacheCreateInfo cacheInfo{};
+  cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cacheInfo.initialDataSize = data.size();
+  cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+  if (vkCreatePipelineCache(_vulkan.device, &cacheInfo, nullptr,
+                            &_vulkan.pipelineCache) != VK_SUCCESS)
+    throw std::runtime_error("WaveVulkanLayer::createPipelineCache: failed to "
+                             "create pipeline cache!");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanLayer::savePipelineCache() {
+  if (_opts.pipeline_cache.empty() || _vulkan.pipelineCache == VK_NULL_HANDLE)
+    return;
+
+  size_t size = 0;
+  if (vkGetPipelineCacheData(_vulkan.device, _vulkan.pipelineCache, &size,
+                             nullptr) != VK_SUCCESS ||
+      size == 0)
+    return;
+
+  std::vector<char> data(size);
+  if (vkGetPipelineCacheData(_vulkan.device, _vulkan.pipelineCache, &size,
+                             data.data()) != VK_SUCCESS)
+    return;
+
+  // failing to persist the cache only costs compilation time on next start
+  std::ofstream file(_opts.pipeline_cache, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    printf("Failed to write pipeline cache %s.\n",
+           _opts.pipeline_cache.c_str());
+    return;
+  }
+  file.write(data.data(), size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void WaveVulkanLayer::createSwapChain() {
   SwapChainSupportDetails swapChainSupport =
       querySwapChainSupport(_vulkan.physicalDevice);
@@ -429,6 +606,26 @@ void WaveVulkanLayer::createSwapChain() {
   createInfo.imageArrayLayers = 1;
   createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
+  // dynamic resolution renders off screen and blits into swapchain images
+  if (_opts.frame_budget > 0.f) {
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(_vulkan.physicalDevice,
+                                        surfaceFormat.format, &props);
+    VkFormatFeatureFlags blitFeatures =
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+    if ((props.optimalTilingFeatures & blitFeatures) == blitFeatures &&
+        (swapChainSupport.capabilities.supportedUsageFlags &
+         VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+      createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    } else {
+      printf("Swapchain format does not support scaled blits, dynamic "
+             "resolution disabled.\n");
+      _opts.frame_budget = 0.f;
+    }
+  }
+
   QueueFamilyIndices indices = findQueueFamilies(_vulkan.physicalDevice);
   uint32_t queueFamilyIndices[] = {indices.graphicsFamily,
                                    indices.presentFamily};
@@ -539,6 +736,33 @@ void WaveVulkanLayer::createRenderPass() {
                          &_vulkan.renderPass) != VK_SUCCESS)
     throw std::runtime_error(
         "WaveVulkanLayer::createRenderPass: failed to create render pass!");
+
+  if (_opts.frame_budget <= 0.f)
+    return;
+
+  // compatible pass rendering into scene image, which is then blitted into
+  // swapchain image, previous blit must finish reading it before clear
+  attachments[0].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+  std::array<VkSubpassDependency, 2> sceneDependencies = {dependency,
+                                                          dependency};
+  sceneDependencies[0].srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+  sceneDependencies[1].srcSubpass = 0;
+  sceneDependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+  sceneDependencies[1].srcStageMask =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  sceneDependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  sceneDependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  sceneDependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+  renderPassInfo.dependencyCount =
+      static_cast<uint32_t>(sceneDependencies.size());
+  renderPassInfo.pDependencies = sceneDependencies.data();
+
+  if (vkCreateRenderPass(_vulkan.device, &renderPassInfo, nullptr,
+                         &_vulkan.sceneRenderPass) != VK_SUCCESS)
+    throw std::runtime_error(
+        "WaveVulkanLayer::createRenderPass: failed to create render pass!");
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -546,13 +770,15 @@ void WaveVulkanLayer::createRenderPass() {
 void WaveVulkanLayer::createUniformBuffer() {
   VkDeviceSize bufferSize = sizeof(UniformBufferObject);
 
-  _vulkan.uniformBuffers.resize(_vulkan.swapChainImages.size());
-  _vulkan.uniformBuffersMemory.resize(_vulkan.swapChainImages.size());
+  _vulkan.uniformBuffers.resize(slotCount());
+  _vulkan.uniformBuffersMemory.resize(slotCount());
 
-  _perFrame.resize(_vulkan.swapChainImages.size());
+  _perFrame.resize(slotCount());
 
   for (size_t i = 0; i < _vulkan.uniformBuffers.size(); i++) {
-    createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+    createBuffer(bufferSize,
+                 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                     VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                  _vulkan.uniformBuffers[i], _vulkan.uniformBuffersMemory[i]);
@@ -567,15 +793,19 @@ void WaveVulkanLayer::createUniformBuffer() {
 void WaveVulkanLayer::createDescriptorSetLayout() {
   VkDescriptorSetLayoutBinding sampler0LayoutBinding{};
   sampler0LayoutBinding.binding = 0;
-  sampler0LayoutBinding.descriptorCount = 1;
+  sampler0LayoutBinding.descriptorCount = MAX_CASCADES;
   sampler0LayoutBinding.descriptorType =
       VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
   sampler0LayoutBinding.pImmutableSamplers = nullptr;
   sampler0LayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+  if (_opts.tessellation)
+    sampler0LayoutBinding.stageFlags |=
+        VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT |
+        VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
 
   VkDescriptorSetLayoutBinding sampler1LayoutBinding{};
   sampler1LayoutBinding.binding = 1;
-  sampler1LayoutBinding.descriptorCount = 1;
+  sampler1LayoutBinding.descriptorCount = MAX_CASCADES;
   sampler1LayoutBinding.descriptorType =
       VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
   sampler1LayoutBinding.pImmutableSamplers = nullptr;
@@ -588,6 +818,10 @@ void WaveVulkanLayer::createDescriptorSetLayout() {
   uniformLayoutBinding.pImmutableSamplers = nullptr;
   uniformLayoutBinding.stageFlags =
       VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+  if (_opts.tessellation)
+    uniformLayoutBinding.stageFlags |=
+        VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT |
+        VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
 
   std::array<VkDescriptorSetLayoutBinding, 3> bindings = {
       sampler0LayoutBinding, sampler1LayoutBinding, uniformLayoutBinding};
@@ -606,7 +840,10 @@ void WaveVulkanLayer::createDescriptorSetLayout() {
 ////////////////////////////////////////////////////////////////////////////////
 
 void WaveVulkanLayer::createGraphicsPipeline() {
-  auto vertShaderCode = readFile("shaders/ocean.vert.spv");
+  auto vertShaderCode = readFile(
+      _opts.tessellation     ? "shaders/ocean_tess.vert.spv"
+      : _opts.vertex_pulling ? "shaders/ocean_pull.vert.spv"
+                             : "shaders/ocean.vert.spv");
   auto fragShaderCode = readFile("shaders/ocean.frag.spv");
 
   VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
@@ -626,8 +863,38 @@ void WaveVulkanLayer::createGraphicsPipeline() {
   fragShaderStageInfo.module = fragShaderModule;
   fragShaderStageInfo.pName = "main";
 
-  VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo,
-                                                    fragShaderStageInfo};
+  std::vector<VkPipelineShaderStageCreateInfo> shaderStages = {
+      vertShaderStageInfo, fragShaderStageInfo};
+
+  // optional adaptive refinement of coarse patches
+  VkShaderModule tescShaderModule = VK_NULL_HANDLE;
+  VkShaderModule teseShaderModule = VK_NULL_HANDLE;
+  if (_opts.tessellation) {
+    tescShaderModule = createShaderModule(readFile("shaders/ocean.tesc.spv"));
+    teseShaderModule = createShaderModule(readFile("shaders/ocean.tese.spv"));
+
+    VkPipelineShaderStageCreateInfo tescShaderStageInfo{};
+    tescShaderStageInfo.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    tescShaderStageInfo.stage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    tescShaderStageInfo.module = tescShaderModule;
+    tescShaderStageInfo.pName = "main";
+
+    VkPipelineShaderStageCreateInfo teseShaderStageInfo{};
+    teseShaderStageInfo.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    teseShaderStageInfo.stage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+    teseShaderStageInfo.module = teseShaderModule;
+    teseShaderStageInfo.pName = "main";
+
+    shaderStages.push_back(tescShaderStageInfo);
+    shaderStages.push_back(teseShaderStageInfo);
+  }
+
+  VkPipelineTessellationStateCreateInfo tessellationState{};
+  tessellationState.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO;
+  tessellationState.patchControlPoints = 3;
 
   // vertex info
   auto bindingDescription = Vertex::getBindingDescription();
@@ -636,17 +903,22 @@ void WaveVulkanLayer::createGraphicsPipeline() {
   VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
   vertexInputInfo.sType =
       VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-  vertexInputInfo.vertexBindingDescriptionCount = 1;
-  vertexInputInfo.vertexAttributeDescriptionCount =
-      static_cast<uint32_t>(attributeDescriptions.size());
-  vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-  vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+  if (!_opts.vertex_pulling) {
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.vertexAttributeDescriptionCount =
+        static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.pVertexAttributeDescriptions =
+        attributeDescriptions.data();
+  }
 
   VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
   inputAssembly.sType =
       VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-  inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
-  inputAssembly.primitiveRestartEnable = VK_TRUE;
+  inputAssembly.topology = _opts.tessellation
+                              ? VK_PRIMITIVE_TOPOLOGY_PATCH_LIST
+                              : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  inputAssembly.primitiveRestartEnable = VK_FALSE;
 
   VkViewport viewport{};
   viewport.x = 0.0f;
@@ -667,13 +939,24 @@ void WaveVulkanLayer::createGraphicsPipeline() {
   viewportState.scissorCount = 1;
   viewportState.pScissors = &scissor;
 
+  // viewport follows swapchain size and render scale, pipelines outlive both
+  std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT,
+                                                 VK_DYNAMIC_STATE_SCISSOR};
+  VkPipelineDynamicStateCreateInfo dynamicState{};
+  dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+  dynamicState.pDynamicStates = dynamicStates.data();
+
   VkPipelineRasterizationStateCreateInfo rasterizer{};
   rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
   rasterizer.depthClampEnable = VK_FALSE;
   rasterizer.rasterizerDiscardEnable = VK_FALSE;
   rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
   rasterizer.lineWidth = 1.0f;
-  rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+  // winding of tessellated triangles depends on domain origin, the few back
+  // faces of the ocean surface are not worth matching it
+  rasterizer.cullMode =
+      _opts.tessellation ? VK_CULL_MODE_NONE : VK_CULL_MODE_BACK_BIT;
   rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
   rasterizer.depthBiasEnable = VK_FALSE;
 
@@ -715,6 +998,19 @@ void WaveVulkanLayer::createGraphicsPipeline() {
   pipelineLayoutInfo.setLayoutCount = 1;
   pipelineLayoutInfo.pSetLayouts = &_vulkan.descriptorSetLayout;
 
+  VkPushConstantRange pushConstantRange{};
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+  pushConstantRange.offset = 0;
+  pushConstantRange.size = sizeof(MeshPushConstants);
+  if (_opts.tessellation) {
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    pushConstantRange.size = sizeof(TessPushConstants);
+  }
+  if (_opts.vertex_pulling || _opts.tessellation) {
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+  }
+
   if (vkCreatePipelineLayout(_vulkan.device, &pipelineLayoutInfo, nullptr,
                              &_vulkan.pipelineLayout) != VK_SUCCESS)
     throw std::runtime_error("WaveVulkanLayer::createGraphicsPipeline: failed "
@@ -722,11 +1018,14 @@ void WaveVulkanLayer::createGraphicsPipeline() {
 
   VkGraphicsPipelineCreateInfo pipelineInfo{};
   pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-  pipelineInfo.stageCount = 2;
-  pipelineInfo.pStages = shaderStages;
+  pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+  pipelineInfo.pStages = shaderStages.data();
   pipelineInfo.pVertexInputState = &vertexInputInfo;
   pipelineInfo.pInputAssemblyState = &inputAssembly;
+  pipelineInfo.pTessellationState =
+      _opts.tessellation ? &tessellationState : nullptr;
   pipelineInfo.pViewportState = &viewportState;
+  pipelineInfo.pDynamicState = &dynamicState;
   pipelineInfo.pRasterizationState = &rasterizer;
   pipelineInfo.pMultisampleState = &multisampling;
   pipelineInfo.pDepthStencilState = &depthStencil;
@@ -736,21 +1035,25 @@ void WaveVulkanLayer::createGraphicsPipeline() {
   pipelineInfo.subpass = 0;
   pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-  if (vkCreateGraphicsPipelines(_vulkan.device, VK_NULL_HANDLE, 1,
+  if (vkCreateGraphicsPipelines(_vulkan.device, _vulkan.pipelineCache, 1,
                                 &pipelineInfo, nullptr,
-                                &_vulkan.graphicsPipeline) != VK_SUCCESS)
+                                &_vulkan.pipelines[PV_SOLID]) != VK_SUCCESS)
     throw std::runtime_error("WaveVulkanLayer::createGraphicsPipeline: failed "
                              "to create graphics pipeline!");
 
   rasterizer.polygonMode = VK_POLYGON_MODE_LINE;
-  if (vkCreateGraphicsPipelines(_vulkan.device, VK_NULL_HANDLE, 1,
+  if (vkCreateGraphicsPipelines(_vulkan.device, _vulkan.pipelineCache, 1,
                                 &pipelineInfo, nullptr,
-                                &_vulkan.wireframePipeline) != VK_SUCCESS)
+                                &_vulkan.pipelines[PV_WIREFRAME]) != VK_SUCCESS)
     throw std::runtime_error("WaveVulkanLayer::createGraphicsPipeline: failed "
                              "to create graphics pipeline!");
 
   vkDestroyShaderModule(_vulkan.device, fragShaderModule, nullptr);
   vkDestroyShaderModule(_vulkan.device, vertShaderModule, nullptr);
+  if (_opts.tessellation) {
+    vkDestroyShaderModule(_vulkan.device, teseShaderModule, nullptr);
+    vkDestroyShaderModule(_vulkan.device, tescShaderModule, nullptr);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -780,6 +1083,41 @@ void WaveVulkanLayer::createFramebuffers() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void WaveVulkanLayer::createSceneTarget() {
+  if (_opts.frame_budget <= 0.f)
+    return;
+
+  // allocated at full swapchain size, lower render scales use its corner
+  createImage(_vulkan.swapChainExtent.width, _vulkan.swapChainExtent.height,
+              _vulkan.swapChainImageFormat, VK_IMAGE_TILING_OPTIMAL,
+              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                  VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _vulkan.sceneImage,
+              _vulkan.sceneImageMemory);
+  _vulkan.sceneImageView =
+      createImageView(_vulkan.sceneImage, _vulkan.swapChainImageFormat,
+                      VK_IMAGE_ASPECT_COLOR_BIT);
+
+  std::array<VkImageView, 2> attachments = {_vulkan.sceneImageView,
+                                            _vulkan.depthImageView};
+
+  VkFramebufferCreateInfo framebufferInfo{};
+  framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+  framebufferInfo.renderPass = _vulkan.sceneRenderPass;
+  framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+  framebufferInfo.pAttachments = attachments.data();
+  framebufferInfo.width = _vulkan.swapChainExtent.width;
+  framebufferInfo.height = _vulkan.swapChainExtent.height;
+  framebufferInfo.layers = 1;
+
+  if (vkCreateFramebuffer(_vulkan.device, &framebufferInfo, nullptr,
+                          &_vulkan.sceneFramebuffer) != VK_SUCCESS)
+    throw std::runtime_error(
+        "WaveVulkanLayer::createSceneTarget: failed to create framebuffer!");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void WaveVulkanLayer::createCommandPool() {
   QueueFamilyIndices queueFamilyIndices =
       findQueueFamilies(_vulkan.physicalDevice);
@@ -787,6 +1125,8 @@ void WaveVulkanLayer::createCommandPool() {
   VkCommandPoolCreateInfo poolInfo{};
   poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
   poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+  // command buffers are re-recorded when render scale changes
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
   if (vkCreateCommandPool(_vulkan.device, &poolInfo, nullptr,
                           &_vulkan.commandPool) != VK_SUCCESS)
@@ -796,32 +1136,198 @@ void WaveVulkanLayer::createCommandPool() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void WaveVulkanLayer::createVertexBuffers() {
+void WaveVulkanLayer::createTimestampPool() {
+  QueueFamilyIndices queueFamilyIndices =
+      findQueueFamilies(_vulkan.physicalDevice);
 
-  int iCXY = (_opts.ocean_grid_size + 1) * (_opts.ocean_grid_size + 1);
-  _vulkan.verts.resize(iCXY);
-
-  cl_float dfY = -0.5 * (_opts.ocean_grid_size * _opts.mesh_spacing),
-           dfBaseX = -0.5 * (_opts.ocean_grid_size * _opts.mesh_spacing);
-  cl_float tx = 0.f, ty = 0.f, dtx = 1.f / _opts.ocean_grid_size,
-           dty = 1.f / _opts.ocean_grid_size;
-  for (int iBase = 0, iY = 0; iY <= _opts.ocean_grid_size;
-       iY++, iBase += _opts.ocean_grid_size + 1) {
-    tx = 0.f;
-    double dfX = dfBaseX;
-    for (int iX = 0; iX <= _opts.ocean_grid_size; iX++) {
-      _vulkan.verts[iBase + iX].pos = glm::vec3(dfX, dfY, 0.0);
-      _vulkan.verts[iBase + iX].tc = glm::vec2(tx, ty);
-      tx += dtx;
-      dfX += _opts.mesh_spacing;
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(_vulkan.physicalDevice,
+                                           &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(
+      _vulkan.physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+  uint32_t validBits =
+      queueFamilies[queueFamilyIndices.graphicsFamily].timestampValidBits;
+  if (validBits == 0) {
+    printf("Graphics queue does not support timestamps, GPU frame time is "
+           "not measured.\n");
+    return;
+  }
+  _vulkan.timestampMask = validBits < 64 ? (1ull << validBits) - 1 : ~0ull;
+
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(_vulkan.physicalDevice, &properties);
+  _vulkan.timestampPeriod = properties.limits.timestampPeriod;
+
+  VkQueryPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  poolInfo.queryCount = static_cast<uint32_t>(2 * slotCount());
+
+  if (vkCreateQueryPool(_vulkan.device, &poolInfo, nullptr,
+                        &_vulkan.timestampPool) != VK_SUCCESS)
+    throw std::runtime_error("WaveVulkanLayer::createTimestampPool: failed to "
+                             "create query pool!");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool WaveVulkanLayer::readTimestamps(size_t slot, float &gpuTime) {
+  if (_vulkan.timestampPool == VK_NULL_HANDLE ||
+      !_perFrame[slot].timestamps_pending)
+    return false;
+
+  // value and availability word of both queries, never waits on device
+  uint64_t results[4] = {};
+  VkResult result = vkGetQueryPoolResults(
+      _vulkan.device, _vulkan.timestampPool, static_cast<uint32_t>(2 * slot),
+      2, sizeof(results), results, 2 * sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+  if (result != VK_SUCCESS || results[1] == 0 || results[3] == 0)
+    return false;
+
+  _perFrame[slot].timestamps_pending = false;
+
+  uint64_t ticks = (results[2] - results[0]) & _vulkan.timestampMask;
+  gpuTime = static_cast<float>(ticks * _vulkan.timestampPeriod * 1e-6);
+  _stats.set(WaveFrameStats::FS_GPU, gpuTime);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanLayer::createClipmapMesh() {
+  _vulkan.verts.clear();
+  _vulkan.inds.clear();
+  _vulkan.tiles.clear();
+
+  // level 0 is a full block of n x n cells, every ring level has n x n cells
+  // of twice the spacing with hole of n/2 x n/2 cells taken by the level below
+  int n = clipmap_block_size(_opts) / clipmap_cell_size(_opts);
+  float spacing = _opts.mesh_spacing * clipmap_cell_size(_opts);
+
+  // each level is split into 4 x 4 tiles of t x t cells, ring levels skip the
+  // 2 x 2 tiles of their hole. Every tile owns a fixed range of vertices,
+  // (t + 1)^2 grid points followed by t midpoints of the edge stitched to the
+  // finer level, ocean.vert derives the same layout from gl_VertexIndex in
+  // vertex pulling mode
+  int t = n / 4;
+  std::uint32_t stride = (t + 1) * (t + 1) + t;
+  float patch = _opts.ocean_grid_size * _opts.mesh_spacing;
+
+  for (int level = 0; level <= (int)_opts.clipmap_levels; level++) {
+    int d = 1 << level;
+    auto holeTile = [&](int ti, int tj) {
+      return level > 0 && ti >= 1 && ti < 3 && tj >= 1 && tj < 3;
+    };
+
+    for (int tj = 0; tj < 4; tj++) {
+      for (int ti = 0; ti < 4; ti++) {
+        if (holeTile(ti, tj))
+          continue;
+
+        // tile origin in units of the finest clipmap cell
+        int x0 = (ti * t - n / 2) * d, y0 = (tj * t - n / 2) * d;
+
+        MeshTile tile;
+        tile.firstIndex = static_cast<std::uint32_t>(_vulkan.inds.size());
+        tile.firstVertex = static_cast<std::int32_t>(_vulkan.verts.size());
+        tile.minXY = glm::vec2(x0, y0) * spacing;
+        tile.maxXY = glm::vec2(x0 + t * d, y0 + t * d) * spacing;
+
+        // edge k joins corners k and k + 1 of a clockwise ordered cell, the
+        // one facing the hole is stitched
+        const int nti[4] = {ti - 1, ti, ti + 1, ti};
+        const int ntj[4] = {tj, tj + 1, tj, tj - 1};
+        int stitch = -1;
+        for (int k = 0; k < 4; k++)
+          if (holeTile(nti[k], ntj[k]))
+            stitch = k;
+
+        _vulkan.verts.resize(_vulkan.verts.size() + stride);
+        Vertex *verts = &_vulkan.verts[tile.firstVertex];
+        auto setVertex = [&](std::uint32_t index, float x, float y) {
+          verts[index].pos = glm::vec3(x * spacing, y * spacing, 0.f);
+          // texture origin matches corner of the former single patch grid
+          verts[index].tc = glm::vec2(x * spacing / patch + 0.5f,
+                                      y * spacing / patch + 0.5f);
+        };
+
+        for (int b = 0; b <= t; b++)
+          for (int a = 0; a <= t; a++)
+            setVertex(b * (t + 1) + a, (float)(x0 + a * d),
+                      (float)(y0 + b * d));
+
+        // midpoints of stitched edge, unused padding on other tiles
+        for (int e = 0; e < t; e++) {
+          float along = (e + 0.5f) * d;
+          glm::vec2 mid(x0, y0);
+          if (stitch == 0)
+            mid += glm::vec2(0.f, along);
+          else if (stitch == 1)
+            mid += glm::vec2(along, (float)(t * d));
+          else if (stitch == 2)
+            mid += glm::vec2((float)(t * d), along);
+          else if (stitch == 3)
+            mid += glm::vec2(along, 0.f);
+          setVertex((t + 1) * (t + 1) + e, mid.x, mid.y);
+        }
+
+        auto grid = [&](int a, int b) {
+          return static_cast<std::uint32_t>(b * (t + 1) + a);
+        };
+
+        for (int b = 0; b < t; b++) {
+          for (int a = 0; a < t; a++) {
+            // cell corners in clockwise order, front face of the pipeline
+            std::uint32_t c[4] = {grid(a, b), grid(a, b + 1),
+                                  grid(a + 1, b + 1), grid(a + 1, b)};
+
+            int k = stitch;
+            bool stitched = (k == 0 && a == 0) || (k == 1 && b == t - 1) ||
+                            (k == 2 && a == t - 1) || (k == 3 && b == 0);
+            if (!stitched) {
+              _vulkan.inds.insert(_vulkan.inds.end(),
+                                  {c[0], c[1], c[3], c[1], c[2], c[3]});
+              continue;
+            }
+
+            // edge facing the finer level has its midpoint vertex, fan the
+            // cell around it to avoid T-junctions
+            std::uint32_t m =
+                (t + 1) * (t + 1) + (k == 0 || k == 2 ? b : a);
+            _vulkan.inds.insert(_vulkan.inds.end(),
+                                {c[k], m, c[(k + 3) % 4], m, c[(k + 1) % 4],
+                                 c[(k + 2) % 4], m, c[(k + 2) % 4],
+                                 c[(k + 3) % 4]});
+          }
+        }
+
+        tile.indexCount =
+            static_cast<std::uint32_t>(_vulkan.inds.size()) - tile.firstIndex;
+        _vulkan.tiles.push_back(tile);
+      }
     }
-    dfY += _opts.mesh_spacing;
-    ty += dty;
   }
 
-  _vulkan.vertexBuffers.resize(_vulkan.swapChainImages.size());
-  _vulkan.vertexBufferMemories.resize(_vulkan.swapChainImages.size());
+  // tile local indices fit 16 bits unless tiles are very large
+  _vulkan.indexType = stride <= 0x10000 ? VK_INDEX_TYPE_UINT16
+                                        : VK_INDEX_TYPE_UINT32;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanLayer::createVertexBuffers() {
+  createClipmapMesh();
 
+  // vertices are generated by ocean.vert, only tile layout is needed
+  if (_opts.vertex_pulling) {
+    _vulkan.verts.clear();
+    return;
+  }
+
+  // mesh is immutable, a single copy is shared by all swapchain images
   VkDeviceSize bufferSize = sizeof(_vulkan.verts[0]) * _vulkan.verts.size();
 
   VkBuffer stagingBuffer;
@@ -836,17 +1342,14 @@ void WaveVulkanLayer::createVertexBuffers() {
   memcpy(data, _vulkan.verts.data(), (size_t)bufferSize);
   vkUnmapMemory(_vulkan.device, stagingBufferMemory);
 
-  for (size_t i = 0; i < _vulkan.swapChainImages.size(); i++) {
-
-    // create local memory buffer
-    createBuffer(bufferSize,
-                 VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _vulkan.vertexBuffers[i],
-                 _vulkan.vertexBufferMemories[i]);
+  // create local memory buffer
+  createBuffer(bufferSize,
+               VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                   VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _vulkan.vertexBuffer,
+               _vulkan.vertexBufferMemory);
 
-    copyBuffer(stagingBuffer, _vulkan.vertexBuffers[i], bufferSize);
-  }
+  copyBuffer(stagingBuffer, _vulkan.vertexBuffer, bufferSize);
 
   vkDestroyBuffer(_vulkan.device, stagingBuffer, nullptr);
   vkFreeMemory(_vulkan.device, stagingBufferMemory, nullptr);
@@ -855,11 +1358,15 @@ void WaveVulkanLayer::createVertexBuffers() {
 ////////////////////////////////////////////////////////////////////////////////
 
 void WaveVulkanLayer::createIndexBuffers() {
-  size_t totalIndices =
-      ((_opts.ocean_grid_size + 1) * 2 + 1) * _opts.ocean_grid_size;
-  _vulkan.inds.resize(totalIndices);
-
+  // indices are generated along with vertices in createClipmapMesh
+  std::vector<std::uint16_t> inds16;
+  const void *indexData = _vulkan.inds.data();
   VkDeviceSize bufferSize = sizeof(_vulkan.inds[0]) * _vulkan.inds.size();
+  if (_vulkan.indexType == VK_INDEX_TYPE_UINT16) {
+    inds16.assign(_vulkan.inds.begin(), _vulkan.inds.end());
+    indexData = inds16.data();
+    bufferSize = sizeof(inds16[0]) * inds16.size();
+  }
 
   VkBuffer stagingBuffer;
   VkDeviceMemory stagingBufferMemory;
@@ -868,36 +1375,18 @@ void WaveVulkanLayer::createIndexBuffers() {
                    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                stagingBuffer, stagingBufferMemory);
 
-  size_t indexCount = 0;
-  for (size_t iY = 0; iY < _opts.ocean_grid_size; iY++) {
-    size_t iBaseFrom = iY * (_opts.ocean_grid_size + 1);
-    size_t iBaseTo = iBaseFrom + _opts.ocean_grid_size + 1;
-
-    for (size_t iX = 0; iX <= _opts.ocean_grid_size; iX++) {
-      _vulkan.inds[indexCount++] = static_cast<int>(iBaseFrom + iX);
-      _vulkan.inds[indexCount++] = static_cast<int>(iBaseTo + iX);
-    }
-    _vulkan.inds[indexCount++] = -1;
-  }
-
   void *data;
   vkMapMemory(_vulkan.device, stagingBufferMemory, 0, bufferSize, 0, &data);
-  memcpy(data, _vulkan.inds.data(), (size_t)bufferSize);
+  memcpy(data, indexData, (size_t)bufferSize);
   vkUnmapMemory(_vulkan.device, stagingBufferMemory);
 
-  _vulkan.indexBuffers.resize(1);
-  _vulkan.indexBuffers[0].buffers.resize(_vulkan.swapChainImages.size());
-  _vulkan.indexBuffers[0].bufferMemories.resize(_vulkan.swapChainImages.size());
+  createBuffer(
+      bufferSize,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _vulkan.indexBuffer,
+      _vulkan.indexBufferMemory);
 
-  for (size_t i = 0; i < _vulkan.swapChainImages.size(); i++) {
-    createBuffer(
-        bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _vulkan.indexBuffers[0].buffers[i],
-        _vulkan.indexBuffers[0].bufferMemories[i]);
-
-    copyBuffer(stagingBuffer, _vulkan.indexBuffers[0].buffers[i], bufferSize);
-  }
+  copyBuffer(stagingBuffer, _vulkan.indexBuffer, bufferSize);
 
   vkDestroyBuffer(_vulkan.device, stagingBuffer, nullptr);
   vkFreeMemory(_vulkan.device, stagingBufferMemory, nullptr);
@@ -905,6 +1394,35 @@ void WaveVulkanLayer::createIndexBuffers() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void WaveVulkanLayer::createIndirectBuffers() {
+  // one command slot per tile, rewritten by cullTiles every frame
+  VkDeviceSize bufferSize =
+      sizeof(VkDrawIndexedIndirectCommand) * _vulkan.tiles.size();
+
+  _vulkan.indirectBuffers.resize(slotCount());
+  _vulkan.indirectBufferMemories.resize(slotCount());
+
+  for (size_t i = 0; i < slotCount(); i++) {
+    createBuffer(bufferSize, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                 _vulkan.indirectBuffers[i], _vulkan.indirectBufferMemories[i]);
+
+    vkMapMemory(_vulkan.device, _vulkan.indirectBufferMemories[i], 0,
+                bufferSize, 0, &_perFrame[i].indirect_memory);
+
+    // draw whole mesh until first culling pass
+    auto *commands = static_cast<VkDrawIndexedIndirectCommand *>(
+        _perFrame[i].indirect_memory);
+    for (size_t tile = 0; tile < _vulkan.tiles.size(); tile++)
+      commands[tile] = {_vulkan.tiles[tile].indexCount, 1,
+                        _vulkan.tiles[tile].firstIndex,
+                        _vulkan.tiles[tile].firstVertex, 0};
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void WaveVulkanLayer::createTextureImages() {
   VkImageTiling tiling =
       _opts.linearImages ? VK_IMAGE_TILING_LINEAR : VK_IMAGE_TILING_OPTIMAL;
@@ -921,15 +1439,43 @@ void WaveVulkanLayer::createTextureImages() {
                    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                _vulkan.stagingBuffer, _vulkan.stagingBufferMemory);
 
+  // simulation writes single level textures, shaders sample separate copies
+  // whose mip chains are blitted every frame
+  _vulkan.textureMipLevels = 1;
+  if (_opts.anisotropy > 0.f) {
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(
+        _vulkan.physicalDevice, VK_FORMAT_R32G32B32A32_SFLOAT, &props);
+    VkFormatFeatureFlags srcFeatures = _opts.linearImages
+                                           ? props.linearTilingFeatures
+                                           : props.optimalTilingFeatures;
+    VkFormatFeatureFlags mipFeatures =
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+    if ((srcFeatures & VK_FORMAT_FEATURE_TRANSFER_SRC_BIT) &&
+        (props.optimalTilingFeatures & mipFeatures) == mipFeatures)
+      _vulkan.textureMipLevels =
+          static_cast<uint32_t>(std::floor(std::log2(texWidth))) + 1;
+    else
+      printf("Ocean texture format does not support linear blits, mipmaps "
+             "disabled.\n");
+  }
+
+  VkImageUsageFlags usage = textureImageUsage();
+  if (_vulkan.textureMipLevels > 1)
+    usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+  // one texture per cascade and resource slot, see cascadeImage
+  size_t imageCount = slotCount() * _opts.cascades;
+
   for (size_t target = 0; target < _vulkan.textureImages.size(); target++) {
-    _vulkan.textureImages[target].images.resize(_vulkan.swapChainImages.size());
-    _vulkan.textureImages[target].imageMemories.resize(
-        _vulkan.swapChainImages.size());
+    _vulkan.textureImages[target].images.resize(imageCount);
+    _vulkan.textureImages[target].imageMemories.resize(imageCount);
 
-    for (size_t i = 0; i < _vulkan.swapChainImages.size(); i++) {
+    for (size_t i = 0; i < imageCount; i++) {
       createShareableImage(
-          texWidth, texHeight, VK_FORMAT_R32G32B32A32_SFLOAT, tiling,
-          VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+          texWidth, texHeight, VK_FORMAT_R32G32B32A32_SFLOAT, tiling, usage,
           properties, _vulkan.textureImages[target].images[i],
           _vulkan.textureImages[target].imageMemories[i]);
       if (_opts.useExternalMemory)
@@ -938,6 +1484,23 @@ void WaveVulkanLayer::createTextureImages() {
                               VK_IMAGE_LAYOUT_UNDEFINED,
                               VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
     }
+
+    if (_vulkan.textureMipLevels == 1)
+      continue;
+
+    _vulkan.textureImages[target].mipImages.resize(imageCount);
+    _vulkan.textureImages[target].mipImageMemories.resize(imageCount);
+
+    for (size_t i = 0; i < imageCount; i++)
+      createImage(texWidth, texHeight, VK_FORMAT_R32G32B32A32_SFLOAT,
+                  VK_IMAGE_TILING_OPTIMAL,
+                  VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                      VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                      VK_IMAGE_USAGE_SAMPLED_BIT,
+                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                  _vulkan.textureImages[target].mipImages[i],
+                  _vulkan.textureImages[target].mipImageMemories[i],
+                  _vulkan.textureMipLevels);
   }
 }
 
@@ -946,13 +1509,24 @@ void WaveVulkanLayer::createTextureImages() {
 void WaveVulkanLayer::createTextureImageViews() {
   for (size_t img_num = 0; img_num < _vulkan.textureImages.size(); img_num++) {
     _vulkan.textureImages[img_num].imageViews.resize(
-        _vulkan.swapChainImages.size());
+        _vulkan.textureImages[img_num].images.size());
 
-    for (size_t i = 0; i < _vulkan.swapChainImages.size(); i++) {
+    for (size_t i = 0; i < _vulkan.textureImages[img_num].images.size(); i++) {
       _vulkan.textureImages[img_num].imageViews[i] = createImageView(
           _vulkan.textureImages[img_num].images[i],
           VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT);
     }
+
+    _vulkan.textureImages[img_num].mipImageViews.resize(
+        _vulkan.textureImages[img_num].mipImages.size());
+
+    for (size_t i = 0; i < _vulkan.textureImages[img_num].mipImages.size();
+         i++) {
+      _vulkan.textureImages[img_num].mipImageViews[i] = createImageView(
+          _vulkan.textureImages[img_num].mipImages[i],
+          VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT,
+          _vulkan.textureMipLevels);
+    }
   }
 }
 
@@ -971,7 +1545,16 @@ void WaveVulkanLayer::createTextureSampler() {
   samplerInfo.unnormalizedCoordinates = VK_FALSE;
   samplerInfo.compareEnable = VK_FALSE;
   samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  samplerInfo.minLod = 0.f;
+  samplerInfo.maxLod = static_cast<float>(_vulkan.textureMipLevels);
+
+  if (_vulkan.textureMipLevels > 1 && _opts.anisotropy > 1.f &&
+      _vulkan.maxSamplerAnisotropy > 1.f) {
+    samplerInfo.anisotropyEnable = VK_TRUE;
+    samplerInfo.maxAnisotropy =
+        std::min(_opts.anisotropy, _vulkan.maxSamplerAnisotropy);
+  }
 
   for (size_t sampler_num = 0; sampler_num < _vulkan.textureSampler.size();
        sampler_num++) {
@@ -985,7 +1568,8 @@ void WaveVulkanLayer::createTextureSampler() {
 ////////////////////////////////////////////////////////////////////////////////
 
 VkImageView WaveVulkanLayer::createImageView(VkImage image, VkFormat format,
-                                             VkImageAspectFlags aspectFlags) {
+                                             VkImageAspectFlags aspectFlags,
+                                             uint32_t mipLevels) {
   VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
   viewInfo.pNext = nullptr;
   viewInfo.image = image;
@@ -993,7 +1577,7 @@ VkImageView WaveVulkanLayer::createImageView(VkImage image, VkFormat format,
   viewInfo.format = format;
   viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
   viewInfo.subresourceRange.baseMipLevel = 0;
-  viewInfo.subresourceRange.levelCount = 1; // VK_REMAINING_MIP_LEVELS;
+  viewInfo.subresourceRange.levelCount = mipLevels;
   viewInfo.subresourceRange.baseArrayLayer = 0;
   viewInfo.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
   viewInfo.subresourceRange.aspectMask = aspectFlags;
@@ -1079,14 +1663,15 @@ void WaveVulkanLayer::createImage(uint32_t width, uint32_t height,
                                   VkFormat format, VkImageTiling tiling,
                                   VkImageUsageFlags usage,
                                   VkMemoryPropertyFlags properties,
-                                  VkImage &image, VkDeviceMemory &imageMemory) {
+                                  VkImage &image, VkDeviceMemory &imageMemory,
+                                  uint32_t mipLevels) {
   VkImageCreateInfo imageInfo{};
   imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   imageInfo.imageType = VK_IMAGE_TYPE_2D;
   imageInfo.extent.width = width;
   imageInfo.extent.height = height;
   imageInfo.extent.depth = 1;
-  imageInfo.mipLevels = 1;
+  imageInfo.mipLevels = mipLevels;
   imageInfo.arrayLayers = 1;
   imageInfo.format = format;
   imageInfo.tiling = tiling;
@@ -1251,6 +1836,99 @@ void WaveVulkanLayer::copyBufferToImage(VkBuffer buffer, VkImage image,
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void WaveVulkanLayer::recordMipChain(VkCommandBuffer commandBuffer,
+                                     VkImage src, VkImage dst) {
+  int32_t size = static_cast<int32_t>(_opts.ocean_tex_size);
+  uint32_t levels = _vulkan.textureMipLevels;
+
+  std::array<VkImageMemoryBarrier, 3> barriers{};
+  for (auto &barrier : barriers) {
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+  }
+
+  // simulation output becomes copy source, previous chain is discarded
+  barriers[0].image = src;
+  barriers[0].oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barriers[0].srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+  barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  barriers[1].image = dst;
+  barriers[1].subresourceRange.levelCount = levels;
+  barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barriers[1].srcAccessMask = 0;
+  barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 2, barriers.data());
+
+  VkImageCopy copy{};
+  copy.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  copy.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  copy.extent = {static_cast<uint32_t>(size), static_cast<uint32_t>(size), 1};
+  vkCmdCopyImage(commandBuffer, src, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst,
+                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+
+  // every level is filtered down from the previous one
+  VkImageMemoryBarrier &level = barriers[1];
+  level.subresourceRange.levelCount = 1;
+  level.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  level.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  level.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  level.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+  for (uint32_t i = 1; i < levels; i++) {
+    level.subresourceRange.baseMipLevel = i - 1;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &level);
+
+    int32_t next = std::max(size / 2, 1);
+    VkImageBlit blit{};
+    blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, i - 1, 0, 1};
+    blit.srcOffsets[1] = {size, size, 1};
+    blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1};
+    blit.dstOffsets[1] = {next, next, 1};
+    vkCmdBlitImage(commandBuffer, dst, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                   VK_FILTER_LINEAR);
+    size = next;
+  }
+
+  // hand simulation output and whole chain back to shaders
+  barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barriers[0].srcAccessMask = 0;
+  barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barriers[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levels - 1, 0,
+                                  1};
+  barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barriers[1].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barriers[1].srcAccessMask = 0;
+  barriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barriers[2].image = dst;
+  barriers[2].subresourceRange.baseMipLevel = levels - 1;
+  barriers[2].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barriers[2].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barriers[2].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barriers[2].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+  VkPipelineStageFlags dstStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  if (_opts.tessellation)
+    dstStages |= VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
+                 VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       dstStages, 0, 0, nullptr, 0, nullptr,
+                       static_cast<uint32_t>(barriers.size()),
+                       barriers.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void WaveVulkanLayer::transitionUniformLayout(VkBuffer buffer,
                                               VkAccessFlagBits src,
                                               VkAccessFlagBits dst) {
@@ -1288,17 +1966,16 @@ void WaveVulkanLayer::createDescriptorPool() {
   std::array<VkDescriptorPoolSize, 2> poolSizes{};
   poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
   poolSizes[0].descriptorCount =
-      static_cast<uint32_t>(_vulkan.swapChainImages.size());
+      static_cast<uint32_t>(slotCount() * IOPT_COUNT * MAX_CASCADES);
 
   poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-  poolSizes[1].descriptorCount =
-      static_cast<uint32_t>(_vulkan.swapChainImages.size());
+  poolSizes[1].descriptorCount = static_cast<uint32_t>(slotCount());
 
   VkDescriptorPoolCreateInfo poolInfo{};
   poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
   poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
   poolInfo.pPoolSizes = poolSizes.data();
-  poolInfo.maxSets = static_cast<uint32_t>(_vulkan.swapChainImages.size());
+  poolInfo.maxSets = static_cast<uint32_t>(slotCount());
 
   if (vkCreateDescriptorPool(_vulkan.device, &poolInfo, nullptr,
                              &_vulkan.descriptorPool) != VK_SUCCESS)
@@ -1309,23 +1986,23 @@ void WaveVulkanLayer::createDescriptorPool() {
 ////////////////////////////////////////////////////////////////////////////////
 
 void WaveVulkanLayer::createDescriptorSets() {
-  std::vector<VkDescriptorSetLayout> layouts(_vulkan.swapChainImages.size(),
+  std::vector<VkDescriptorSetLayout> layouts(slotCount(),
                                              _vulkan.descriptorSetLayout);
   VkDescriptorSetAllocateInfo allocInfo{};
   allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
   allocInfo.descriptorPool = _vulkan.descriptorPool;
-  allocInfo.descriptorSetCount =
-      static_cast<uint32_t>(_vulkan.swapChainImages.size());
+  allocInfo.descriptorSetCount = static_cast<uint32_t>(slotCount());
   allocInfo.pSetLayouts = layouts.data();
 
-  _vulkan.descriptorSets.resize(_vulkan.swapChainImages.size());
+  _vulkan.descriptorSets.resize(slotCount());
   if (vkAllocateDescriptorSets(_vulkan.device, &allocInfo,
                                _vulkan.descriptorSets.data()) != VK_SUCCESS)
     throw std::runtime_error("WaveVulkanLayer::createDescriptorSets: failed to "
                              "allocate descriptor sets!");
 
-  for (size_t i = 0; i < _vulkan.swapChainImages.size(); i++) {
-    VkDescriptorImageInfo imageInfo[(size_t)InteropTexType::IOPT_COUNT] = {0};
+  for (size_t i = 0; i < slotCount(); i++) {
+    VkDescriptorImageInfo imageInfo[(size_t)InteropTexType::IOPT_COUNT]
+                                   [MAX_CASCADES] = {};
 
     VkDescriptorBufferInfo bufferInfo{};
     bufferInfo.buffer = _vulkan.uniformBuffers[i];
@@ -1335,9 +2012,18 @@ void WaveVulkanLayer::createDescriptorSets() {
     std::array<VkWriteDescriptorSet, IOPT_COUNT + 1> descriptorWrites{};
 
     for (cl_int target = 0; target < IOPT_COUNT; target++) {
-      imageInfo[target].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-      imageInfo[target].imageView = _vulkan.textureImages[target].imageViews[i];
-      imageInfo[target].sampler = _vulkan.textureSampler[target];
+      // unused cascade slots repeat the first one, shaders skip them
+      for (size_t cascade = 0; cascade < MAX_CASCADES; cascade++) {
+        size_t view =
+            cascadeImage(i, cascade < _opts.cascades ? cascade : 0);
+        imageInfo[target][cascade].imageLayout =
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo[target][cascade].imageView =
+            _vulkan.textureMipLevels > 1
+                ? _vulkan.textureImages[target].mipImageViews[view]
+                : _vulkan.textureImages[target].imageViews[view];
+        imageInfo[target][cascade].sampler = _vulkan.textureSampler[target];
+      }
 
       descriptorWrites[target].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
       descriptorWrites[target].dstSet = _vulkan.descriptorSets[i];
@@ -1345,8 +2031,8 @@ void WaveVulkanLayer::createDescriptorSets() {
       descriptorWrites[target].dstArrayElement = 0;
       descriptorWrites[target].descriptorType =
           VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-      descriptorWrites[target].descriptorCount = 1;
-      descriptorWrites[target].pImageInfo = &imageInfo[target];
+      descriptorWrites[target].descriptorCount = MAX_CASCADES;
+      descriptorWrites[target].pImageInfo = imageInfo[target];
     }
 
     descriptorWrites[IOPT_COUNT].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -1492,72 +2178,270 @@ void WaveVulkanLayer::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
 ////////////////////////////////////////////////////////////////////////////////
 
 void WaveVulkanLayer::createCommandBuffers() {
-  _vulkan.commandBuffers.resize(_vulkan.swapChainFramebuffers.size());
-  _perFrame.resize(_vulkan.swapChainFramebuffers.size());
+  size_t imageCount = _vulkan.swapChainFramebuffers.size();
+
+  // every pipeline variant keeps its own pre-recorded set, switching between
+  // them is a choice made at submit time
+  for (size_t variant = 0; variant < PV_COUNT; variant++) {
+    auto &commandBuffers = _vulkan.commandBuffers[variant];
+    commandBuffers.resize(slotCount() * imageCount);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = _vulkan.commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+
+    if (vkAllocateCommandBuffers(_vulkan.device, &allocInfo,
+                                 commandBuffers.data()) != VK_SUCCESS)
+      throw std::runtime_error("WaveVulkanLayer::createCommandBuffers: failed "
+                               "to allocate command buffers!");
 
-  VkCommandBufferAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  allocInfo.commandPool = _vulkan.commandPool;
-  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  allocInfo.commandBufferCount = (uint32_t)_vulkan.commandBuffers.size();
+    for (size_t slot = 0; slot < slotCount(); slot++)
+      for (size_t image = 0; image < imageCount; image++)
+        recordCommandBuffer(slot, image, static_cast<PipelineVariant>(variant));
+  }
+}
 
-  if (vkAllocateCommandBuffers(_vulkan.device, &allocInfo,
-                               _vulkan.commandBuffers.data()) != VK_SUCCESS)
-    throw std::runtime_error("WaveVulkanLayer::createCommandBuffers: failed to "
-                             "allocate command buffers!");
+////////////////////////////////////////////////////////////////////////////////
 
-  for (size_t i = 0; i < _vulkan.commandBuffers.size(); i++) {
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+void WaveVulkanLayer::recordCommandBuffer(size_t slot, size_t image,
+                                          PipelineVariant variant) {
+  size_t buffer = slot * _vulkan.swapChainImages.size() + image;
+  VkCommandBuffer commandBuffer = _vulkan.commandBuffers[variant][buffer];
 
-    if (vkBeginCommandBuffer(_vulkan.commandBuffers[i], &beginInfo) !=
-        VK_SUCCESS)
-      throw std::runtime_error("WaveVulkanLayer::createCommandBuffers: failed "
-                               "to begin recording command buffer!");
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
-    VkRenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = _vulkan.renderPass;
-    renderPassInfo.framebuffer = _vulkan.swapChainFramebuffers[i];
-    renderPassInfo.renderArea.offset = {0, 0};
-    renderPassInfo.renderArea.extent = _vulkan.swapChainExtent;
+  if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    throw std::runtime_error("WaveVulkanLayer::recordCommandBuffer: failed to "
+                             "begin recording command buffer!");
+
+  if (_vulkan.textureMipLevels > 1) {
+    for (size_t target = 0; target < IOPT_COUNT; target++)
+      for (size_t cascade = 0; cascade < _opts.cascades; cascade++) {
+        size_t view = cascadeImage(slot, cascade);
+        recordMipChain(commandBuffer,
+                       _vulkan.textureImages[target].images[view],
+                       _vulkan.textureImages[target].mipImages[view]);
+      }
+  }
 
-    std::array<VkClearValue, 2> clearValues{};
-    clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
-    clearValues[1].depthStencil = {1.0f, 0};
+  // scaled frames are rendered off screen into the top left corner of scene
+  // image and stretched over the swapchain image afterwards
+  bool scaled = _opts.frame_budget > 0.f;
+  VkExtent2D extent = renderExtent();
+
+  VkRenderPassBeginInfo renderPassInfo{};
+  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  renderPassInfo.renderPass =
+      scaled ? _vulkan.sceneRenderPass : _vulkan.renderPass;
+  renderPassInfo.framebuffer =
+      scaled ? _vulkan.sceneFramebuffer : _vulkan.swapChainFramebuffers[image];
+  renderPassInfo.renderArea.offset = {0, 0};
+  renderPassInfo.renderArea.extent = extent;
+
+  std::array<VkClearValue, 2> clearValues{};
+  clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+  clearValues[1].depthStencil = {1.0f, 0};
+
+  renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+  renderPassInfo.pClearValues = clearValues.data();
+
+  uint32_t query = static_cast<uint32_t>(2 * slot);
+  if (_vulkan.timestampPool != VK_NULL_HANDLE) {
+    vkCmdResetQueryPool(commandBuffer, _vulkan.timestampPool, query, 2);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                        _vulkan.timestampPool, query);
+  }
 
-    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-    renderPassInfo.pClearValues = clearValues.data();
+  vkCmdBeginRenderPass(commandBuffer, &renderPassInfo,
+                       VK_SUBPASS_CONTENTS_INLINE);
 
-    vkCmdBeginRenderPass(_vulkan.commandBuffers[i], &renderPassInfo,
-                         VK_SUBPASS_CONTENTS_INLINE);
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    _vulkan.pipelines[variant]);
 
-    vkCmdBindPipeline(_vulkan.commandBuffers[i],
-                      VK_PIPELINE_BIND_POINT_GRAPHICS,
-                      _opts.wireframe_mode ? _vulkan.wireframePipeline
-                                           : _vulkan.graphicsPipeline);
+  VkViewport viewport{};
+  viewport.width = (float)extent.width;
+  viewport.height = (float)extent.height;
+  viewport.minDepth = 0.0f;
+  viewport.maxDepth = 1.0f;
+  vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
+  VkRect2D scissor{};
+  scissor.offset = {0, 0};
+  scissor.extent = extent;
+  vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+  if (_opts.vertex_pulling) {
+    MeshPushConstants mesh;
+    mesh.spacing = _opts.mesh_spacing;
+    mesh.inv_patch = 1.f / (_opts.ocean_grid_size * _opts.mesh_spacing);
+    mesh.tile_cells = clipmap_block_size(_opts) / clipmap_cell_size(_opts) / 4;
+    vkCmdPushConstants(commandBuffer, _vulkan.pipelineLayout,
+                       VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mesh), &mesh);
+  } else {
     VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(_vulkan.commandBuffers[i], 0, 1,
-                           &_vulkan.vertexBuffers[i], offsets);
-
-    vkCmdBindDescriptorSets(
-        _vulkan.commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS,
-        _vulkan.pipelineLayout, 0, 1, &_vulkan.descriptorSets[i], 0, nullptr);
-
-    for (auto ind_buffer : _vulkan.indexBuffers) {
-      vkCmdBindIndexBuffer(_vulkan.commandBuffers[i], ind_buffer.buffers[i], 0,
-                           VK_INDEX_TYPE_UINT32);
-      vkCmdDrawIndexed(_vulkan.commandBuffers[i],
-                       static_cast<uint32_t>(_vulkan.inds.size()), 1, 0, 0, 0);
-    }
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &_vulkan.vertexBuffer,
+                           offsets);
+  }
 
-    vkCmdEndRenderPass(_vulkan.commandBuffers[i]);
+  if (_opts.tessellation) {
+    TessPushConstants tess;
+    tess.viewport = glm::vec2(extent.width, extent.height);
+    tess.edge_pixels = _opts.tess_edge_pixels;
+    tess.max_level = std::min(64.f, _vulkan.maxTessellationLevel);
+    tess.curvature_scale = 4.f;
+    vkCmdPushConstants(commandBuffer, _vulkan.pipelineLayout,
+                       VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT, 0,
+                       sizeof(tess), &tess);
+  }
 
-    if (vkEndCommandBuffer(_vulkan.commandBuffers[i]) != VK_SUCCESS)
-      throw std::runtime_error("WaveVulkanLayer::createCommandBuffers: failed "
-                               "to record command buffer!");
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          _vulkan.pipelineLayout, 0, 1,
+                          &_vulkan.descriptorSets[slot], 0, nullptr);
+
+  // command count is fixed at record time, slots of culled tiles are
+  // filled with empty draws by cullTiles
+  uint32_t drawCount = static_cast<uint32_t>(_vulkan.tiles.size());
+  uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+  vkCmdBindIndexBuffer(commandBuffer, _vulkan.indexBuffer, 0,
+                       _vulkan.indexType);
+  if (_vulkan.multiDrawIndirect) {
+    vkCmdDrawIndexedIndirect(commandBuffer, _vulkan.indirectBuffers[slot], 0,
+                             drawCount, stride);
+  } else {
+    for (uint32_t draw = 0; draw < drawCount; draw++)
+      vkCmdDrawIndexedIndirect(commandBuffer, _vulkan.indirectBuffers[slot],
+                               draw * stride, 1, stride);
   }
+
+  vkCmdEndRenderPass(commandBuffer);
+
+  if (_vulkan.timestampPool != VK_NULL_HANDLE)
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        _vulkan.timestampPool, query + 1);
+
+  if (scaled)
+    recordUpscale(commandBuffer, image, extent);
+
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    throw std::runtime_error("WaveVulkanLayer::recordCommandBuffer: failed to "
+                             "record command buffer!");
+
+  _perFrame[slot].render_scale = _renderScale;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanLayer::recordUpscale(VkCommandBuffer commandBuffer,
+                                    size_t currentImage, VkExtent2D extent) {
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = _vulkan.swapChainImages[currentImage];
+  barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+  // acquire semaphore is waited on at color output stage, chain blit to it
+  barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(commandBuffer,
+                       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+
+  VkImageBlit blit{};
+  blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  blit.srcOffsets[1] = {static_cast<int32_t>(extent.width),
+                        static_cast<int32_t>(extent.height), 1};
+  blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  blit.dstOffsets[1] = {static_cast<int32_t>(_vulkan.swapChainExtent.width),
+                        static_cast<int32_t>(_vulkan.swapChainExtent.height),
+                        1};
+  vkCmdBlitImage(commandBuffer, _vulkan.sceneImage,
+                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                 _vulkan.swapChainImages[currentImage],
+                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                 VK_FILTER_LINEAR);
+
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = 0;
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+VkExtent2D WaveVulkanLayer::renderExtent() const {
+  if (_opts.frame_budget <= 0.f)
+    return _vulkan.swapChainExtent;
+
+  VkExtent2D extent;
+  extent.width = std::max(
+      1u, static_cast<uint32_t>(_vulkan.swapChainExtent.width * _renderScale));
+  extent.height = std::max(
+      1u, static_cast<uint32_t>(_vulkan.swapChainExtent.height * _renderScale));
+  return extent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanLayer::updateRenderScale(float renderTime) {
+  if (_opts.frame_budget <= 0.f)
+    return;
+
+  _frameTimeAvg += (renderTime - _frameTimeAvg) * 0.1f;
+
+  // let the average settle on the new resolution before the next step
+  if (++_framesSinceScale < 30)
+    return;
+
+  float scale = _renderScale;
+  if (_frameTimeAvg > _opts.frame_budget * 1.05f)
+    scale -= RENDER_SCALE_STEP;
+  else if (_frameTimeAvg < _opts.frame_budget * 0.8f)
+    scale += RENDER_SCALE_STEP;
+  scale = std::min(std::max(scale, _opts.min_render_scale), 1.f);
+
+  if (scale != _renderScale) {
+    _renderScale = scale;
+    _framesSinceScale = 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanLayer::paceFrame() {
+  if (_opts.max_fps <= 0.f)
+    return;
+
+  using clock = std::chrono::steady_clock;
+  clock::duration period = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<float>(1.f / _opts.max_fps));
+
+  // missed deadlines restart the schedule instead of bursting to catch up
+  clock::time_point now = clock::now();
+  if (now > _frameDeadline)
+    _frameDeadline = now + period;
+
+  // the limiter starts a frame once the previous period is over, pacing
+  // postpones it until the averaged work time plus a tenth of period margin
+  // still fits before the deadline, so simulation samples the latest time
+  clock::time_point start = _frameDeadline - period;
+  if (_opts.frame_pacing) {
+    auto work = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<float, std::milli>(_workTimeAvg));
+    start = std::max(start, _frameDeadline - work - period / 10);
+  }
+
+  std::this_thread::sleep_until(start);
+  _frameDeadline += period;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1567,6 +2451,7 @@ void WaveVulkanLayer::createSyncObjects() {
   _vulkan.renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
   _vulkan.inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
   _vulkan.imagesInFlight.resize(_vulkan.swapChainImages.size(), VK_NULL_HANDLE);
+  _vulkan.slotsInFlight.resize(slotCount(), VK_NULL_HANDLE);
 
   VkExportSemaphoreCreateInfo exportSemaphoreCreateInfo{};
   exportSemaphoreCreateInfo.sType =
@@ -1609,42 +2494,162 @@ void WaveVulkanLayer::updateUniforms(uint32_t currentImage) {
   ubo.z_range_min = z_range.x;
   ubo.z_range_max = z_range.y;
 
+  int patch = cascade_patch_size(_opts, 0);
+  ubo.cascade_count = static_cast<std::int32_t>(_opts.cascades);
+  for (size_t cascade = 0; cascade < _opts.cascades; cascade++)
+    ubo.cascade_scale[cascade] =
+        (float)patch / cascade_patch_size(_opts, cascade);
+
+  // clipmap follows the camera in steps of its coarsest cell so vertices of
+  // every level stay on their own lattice and do not swim over the waves
+  float snap = _opts.mesh_spacing * clipmap_cell_size(_opts) *
+               (1 << _opts.clipmap_levels);
+  ubo.grid_offset =
+      glm::floor(glm::vec2(_opts.camera.eye) / snap + 0.5f) * snap;
+  ubo.grid_tex_offset =
+      ubo.grid_offset / (_opts.ocean_grid_size * _opts.mesh_spacing);
+
   // update camera related uniform
   glm::mat4 view_matrix = glm::lookAt(
       _opts.camera.eye, _opts.camera.eye + _opts.camera.dir, _opts.camera.up);
 
   float fov = glm::radians(60.0);
-  float aspect = (float)_opts.window_width / _opts.window_height;
-  glm::mat4 proj_matrix = glm::perspective(
-      fov, aspect, 1.f, 2.f * _opts.ocean_grid_size * _opts.mesh_spacing);
+  float aspect =
+      (float)_vulkan.swapChainExtent.width / _vulkan.swapChainExtent.height;
+  glm::mat4 proj_matrix =
+      glm::perspective(fov, aspect, 1.f, 4.f * clipmap_half_extent(_opts));
   proj_matrix[1][1] *= -1;
 
   ubo.view_mat = view_matrix;
   ubo.proj_mat = proj_matrix;
 
+  cullTiles(currentImage, proj_matrix * view_matrix, ubo.grid_offset);
+
   memcpy(_perFrame[currentImage].buffer_memory, &ubo,
          sizeof(UniformBufferObject));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void WaveVulkanLayer::cullTiles(uint32_t currentImage,
+                                const glm::mat4 &view_proj,
+                                const glm::vec2 &offset) {
+  // frustum planes from rows of the view-projection matrix
+  glm::mat4 m = glm::transpose(view_proj);
+  const glm::vec4 planes[] = {m[3] + m[0], m[3] - m[0], m[3] + m[1],
+                              m[3] - m[1], m[3] + m[2], m[3] - m[2]};
+
+  // conservative bounds of displaced tile, reduced displacement of all
+  // cascades is scaled by the largest factors of ocean.vert, where z_bias is
+  // clamped to 1
+  float dz = displ_bound.x * _opts.alt_scale * 1.3f;
+  float dxy = displ_bound.y * _opts.choppiness * 2.f;
+
+  auto *commands = static_cast<VkDrawIndexedIndirectCommand *>(
+      _perFrame[currentImage].indirect_memory);
+  uint32_t drawCount = 0;
+
+  for (const auto &tile : _vulkan.tiles) {
+    glm::vec3 bmin(tile.minXY + offset - dxy, -dz);
+    glm::vec3 bmax(tile.maxXY + offset + dxy, dz);
+
+    bool visible = true;
+    for (const auto &plane : planes) {
+      // corner of the box furthest along plane normal
+      glm::vec3 p(plane.x > 0.f ? bmax.x : bmin.x,
+                  plane.y > 0.f ? bmax.y : bmin.y,
+                  plane.z > 0.f ? bmax.z : bmin.z);
+      if (glm::dot(glm::vec3(plane), p) + plane.w < 0.f) {
+        visible = false;
+        break;
+      }
+    }
+
+    if (!visible)
+      continue;
+
+    commands[drawCount++] = {tile.indexCount, 1, tile.firstIndex,
+                             tile.firstVertex, 0};
+  }
+
+  for (size_t i = drawCount; i < _vulkan.tiles.size(); i++)
+    commands[i] = {0, 0, 0, 0, 0};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void WaveVulkanLayer::drawFrame() {
+  using clock = std::chrono::steady_clock;
+  using ms = std::chrono::duration<float, std::milli>;
+
+  clock::time_point frameStart = clock::now();
+  float frameTime = ms(frameStart - _lastFrameTime).count();
+  _lastFrameTime = frameStart;
+  _stats.set(WaveFrameStats::FS_FRAME, frameTime);
+
+  // host time spent waiting on device or the pacing schedule
+  float blocked = 0.f;
+
+  clock::time_point waitStart = clock::now();
   vkWaitForFences(_vulkan.device, 1, &_vulkan.inFlightFences[_currentFrame],
                   VK_TRUE, UINT64_MAX);
+  float fenceTime = ms(clock::now() - waitStart).count();
 
   uint32_t imageIndex;
-  vkAcquireNextImageKHR(_vulkan.device, _vulkan.swapChain, UINT64_MAX,
-                        _vulkan.imageAvailableSemaphores[_currentFrame],
-                        VK_NULL_HANDLE, &imageIndex);
+  VkResult result = vkAcquireNextImageKHR(
+      _vulkan.device, _vulkan.swapChain, UINT64_MAX,
+      _vulkan.imageAvailableSemaphores[_currentFrame], VK_NULL_HANDLE,
+      &imageIndex);
 
-  updateSolver(imageIndex);
+  if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+    recreateSwapChain();
+    return;
+  } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+    throw std::runtime_error(
+        "WaveVulkanLayer::drawFrame: failed to acquire swap chain image!");
 
+  waitStart = clock::now();
   if (_vulkan.imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
     vkWaitForFences(_vulkan.device, 1, &_vulkan.imagesInFlight[imageIndex],
                     VK_TRUE, UINT64_MAX);
   }
   _vulkan.imagesInFlight[imageIndex] = _vulkan.inFlightFences[_currentFrame];
 
+  // textures, uniforms and command buffers of the slot are rewritten below,
+  // the last frame which used them has to be retired first
+  size_t slot = _currentSlot;
+  if (_vulkan.slotsInFlight[slot] != VK_NULL_HANDLE) {
+    vkWaitForFences(_vulkan.device, 1, &_vulkan.slotsInFlight[slot], VK_TRUE,
+                    UINT64_MAX);
+  }
+  _vulkan.slotsInFlight[slot] = _vulkan.inFlightFences[_currentFrame];
+  fenceTime += ms(clock::now() - waitStart).count();
+  _stats.set(WaveFrameStats::FS_FENCE, fenceTime);
+  blocked += fenceTime;
+
+  // the slot's previous frame has retired, its render pass time is ready;
+  // frame interval includes fences, vsync and pacing and only stands in
+  // for devices without timestamps
+  float gpuTime = 0.f;
+  if (readTimestamps(slot, gpuTime))
+    updateRenderScale(gpuTime);
+  else if (_vulkan.timestampPool == VK_NULL_HANDLE)
+    updateRenderScale(frameTime);
+
+  waitStart = clock::now();
+  paceFrame();
+  clock::time_point workStart = clock::now();
+  blocked += ms(workStart - waitStart).count();
+
+  updateSolver(static_cast<uint32_t>(slot));
+  _stats.set(WaveFrameStats::FS_SOLVER, ms(clock::now() - workStart).count());
+
+  if (_perFrame[slot].render_scale != _renderScale)
+    for (size_t variant = 0; variant < PV_COUNT; variant++)
+      for (size_t image = 0; image < _vulkan.swapChainImages.size(); image++)
+        recordCommandBuffer(slot, image,
+                            static_cast<PipelineVariant>(variant));
+
   VkSubmitInfo submitInfo{};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
@@ -1656,8 +2661,17 @@ void WaveVulkanLayer::drawFrame() {
   submitInfo.pWaitSemaphores = waitSemaphores.data();
   submitInfo.pWaitDstStageMask = waitStages.data();
 
-  submitInfo.commandBufferCount = 1;
-  submitInfo.pCommandBuffers = &_vulkan.commandBuffers[imageIndex];
+  std::vector<VkCommandBuffer> submitBuffers;
+  VkCommandBuffer computeBuffer =
+      computeCommandBuffer(static_cast<uint32_t>(slot));
+  if (computeBuffer != VK_NULL_HANDLE)
+    submitBuffers.push_back(computeBuffer);
+  PipelineVariant variant = _opts.wireframe_mode ? PV_WIREFRAME : PV_SOLID;
+  size_t buffer = slot * _vulkan.swapChainImages.size() + imageIndex;
+  submitBuffers.push_back(_vulkan.commandBuffers[variant][buffer]);
+
+  submitInfo.commandBufferCount = static_cast<uint32_t>(submitBuffers.size());
+  submitInfo.pCommandBuffers = submitBuffers.data();
 
   submitInfo.signalSemaphoreCount = 1;
   submitInfo.pSignalSemaphores =
@@ -1670,6 +2684,11 @@ void WaveVulkanLayer::drawFrame() {
     throw std::runtime_error(
         "WaveVulkanLayer::drawFrame: failed to submit draw command buffer!");
 
+  _perFrame[slot].timestamps_pending = _vulkan.timestampPool != VK_NULL_HANDLE;
+
+  float work = ms(clock::now() - workStart).count();
+  _workTimeAvg += (work - _workTimeAvg) * 0.1f;
+
   VkPresentInfoKHR presentInfo{};
   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -1683,9 +2702,21 @@ void WaveVulkanLayer::drawFrame() {
 
   presentInfo.pImageIndices = &imageIndex;
 
-  vkQueuePresentKHR(_vulkan.presentQueue, &presentInfo);
+  result = vkQueuePresentKHR(_vulkan.presentQueue, &presentInfo);
 
   _currentFrame = (_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+  _currentSlot = (_currentSlot + 1) % slotCount();
+
+  _stats.set(WaveFrameStats::FS_CPU,
+             ms(clock::now() - frameStart).count() - blocked);
+  _stats.endFrame();
+
+  if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
+      _opts.resized)
+    recreateSwapChain();
+  else if (result != VK_SUCCESS)
+    throw std::runtime_error(
+        "WaveVulkanLayer::drawFrame: failed to present swap chain image!");
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1721,16 +2752,21 @@ VkSurfaceFormatKHR WaveVulkanLayer::chooseSwapSurfaceFormat(
 
 VkPresentModeKHR WaveVulkanLayer::chooseSwapPresentMode(
     const std::vector<VkPresentModeKHR> &availablePresentModes) {
+  const VkPresentModeKHR modes[] = {VK_PRESENT_MODE_FIFO_KHR,
+                                    VK_PRESENT_MODE_MAILBOX_KHR,
+                                    VK_PRESENT_MODE_IMMEDIATE_KHR};
+  if (_opts.present_mode >= sizeof(modes) / sizeof(modes[0]))
+    _opts.present_mode = 0;
+
+  // FIFO is the only mode every implementation has to support
+  VkPresentModeKHR requested = modes[_opts.present_mode];
   for (const auto &availablePresentMode : availablePresentModes) {
-    if (!_opts.immediate) {
-      if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-        return availablePresentMode;
-    } else {
-      if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
-        return availablePresentMode;
-    }
+    if (availablePresentMode == requested)
+      return availablePresentMode;
   }
 
+  printf("Requested present mode not supported, using FIFO.\n");
+  _opts.present_mode = 0;
   return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -24,6 +24,7 @@ SOFTWARE.
 #ifndef _WAVE_MODEL_BASE_HPP_
 #define _WAVE_MODEL_BASE_HPP_
 
+#include "wave_frame_stats.hpp"
 #include "wave_util.hpp"
 
 #include <chrono>
@@ -44,10 +45,14 @@ public:
   void init(GLFWwindow *window);
   void drawFrame();
   void wait();
-  void createCommandBuffers();
+
+  WaveFrameStats &stats() { return _stats; }
 
   enum InteropTexType { IOPT_DISPLACEMENT = 0, IOPT_NORMAL_MAP, IOPT_COUNT };
 
+  // graphics pipelines with their own pre-recorded command buffers
+  enum PipelineVariant { PV_SOLID = 0, PV_WIREFRAME, PV_COUNT };
+
 protected:
 
 #ifdef _WIN32
@@ -60,6 +65,10 @@ protected:
 
   glm::vec2 z_range = glm::vec2(0, 0);
 
+  // height and horizontal displacement bounds summed over cascades, before
+  // scaling of ocean.vert, keep culled tiles conservative
+  glm::vec2 displ_bound = glm::vec2(0, 0);
+
   std::chrono::system_clock::time_point start =
       std::chrono::system_clock::now();
 
@@ -88,11 +97,25 @@ protected:
     VkRenderPass renderPass;
     VkDescriptorSetLayout descriptorSetLayout;
     VkPipelineLayout pipelineLayout;
-    VkPipeline graphicsPipeline;
-    VkPipeline wireframePipeline;
+    std::array<VkPipeline, PV_COUNT> pipelines;
+
+    // off screen target of dynamic render resolution, blitted to swapchain
+    VkRenderPass sceneRenderPass = VK_NULL_HANDLE;
+    VkImage sceneImage = VK_NULL_HANDLE;
+    VkDeviceMemory sceneImageMemory = VK_NULL_HANDLE;
+    VkImageView sceneImageView = VK_NULL_HANDLE;
+    VkFramebuffer sceneFramebuffer = VK_NULL_HANDLE;
 
     VkCommandPool commandPool;
 
+    // begin/end timestamps of the render pass, one pair per resource slot
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    float timestampPeriod = 1.f;
+    uint64_t timestampMask = ~0ull;
+
+    // shared by graphics and compute pipelines, persisted across runs
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+
     VkBuffer stagingBuffer;
     VkDeviceMemory stagingBufferMemory;
 
@@ -100,6 +123,11 @@ protected:
       std::vector<VkImage> images;
       std::vector<VkDeviceMemory> imageMemories;
       std::vector<VkImageView> imageViews;
+
+      // sampled copies with full mip chain rebuilt every frame
+      std::vector<VkImage> mipImages;
+      std::vector<VkDeviceMemory> mipImageMemories;
+      std::vector<VkImageView> mipImageViews;
     };
 
     // vulkan-opencl interop resources
@@ -107,28 +135,47 @@ protected:
 
     // Ocean grid vertices and related buffers
     std::vector<Vertex> verts;
-    std::vector<VkBuffer> vertexBuffers;
-    std::vector<VkDeviceMemory> vertexBufferMemories;
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
 
+    // tile local indices, uploaded as 16-bit when every tile allows
     std::vector<std::uint32_t> inds;
-    struct IndexBuffer {
-      std::vector<VkBuffer> buffers;
-      std::vector<VkDeviceMemory> bufferMemories;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
+
+    // clipmap tiles with their index/vertex ranges and mesh space bounds
+    struct MeshTile {
+      std::uint32_t firstIndex;
+      std::uint32_t indexCount;
+      std::int32_t firstVertex;
+      glm::vec2 minXY;
+      glm::vec2 maxXY;
     };
-    std::vector<IndexBuffer> indexBuffers;
+    std::vector<MeshTile> tiles;
+
+    // draw commands of tiles surviving frustum culling
+    std::vector<VkBuffer> indirectBuffers;
+    std::vector<VkDeviceMemory> indirectBufferMemories;
+    bool multiDrawIndirect = false;
+    float maxTessellationLevel = 64.f;
+    float maxSamplerAnisotropy = 0.f;
+    uint32_t textureMipLevels = 1;
 
     std::array<VkSampler, IOPT_COUNT> textureSampler;
 
     VkDescriptorPool descriptorPool;
     std::vector<VkDescriptorSet> descriptorSets;
 
-    std::vector<VkCommandBuffer> commandBuffers;
+    // one command buffer per resource slot and swapchain image pair
+    std::array<std::vector<VkCommandBuffer>, PV_COUNT> commandBuffers;
 
     std::vector<VkSemaphore> imageAvailableSemaphores;
     std::vector<VkSemaphore> renderFinishedSemaphores;
     std::vector<VkSemaphore> openclFinishedSemaphores;
     std::vector<VkFence> inFlightFences;
     std::vector<VkFence> imagesInFlight;
+    std::vector<VkFence> slotsInFlight;
 
     std::vector<VkBuffer> uniformBuffers;
     std::vector<VkDeviceMemory> uniformBuffersMemory;
@@ -138,13 +185,34 @@ protected:
 
   size_t _currentFrame = 0;
 
+  // resource ring slot of the frame being prepared
+  size_t _currentSlot = 0;
+
   struct PerFrameData {
     UniformBufferObject data;
     void *buffer_memory;
+    void *indirect_memory;
+    // render scale the command buffers of this slot were recorded with
+    float render_scale = 0.f;
+    // submitted timestamps not read back yet
+    bool timestamps_pending = false;
   };
 
   std::vector<PerFrameData> _perFrame;
 
+  // dynamic render resolution state
+  float _renderScale = 1.f;
+  float _frameTimeAvg = 0.f;
+  size_t _framesSinceScale = 0;
+  std::chrono::steady_clock::time_point _lastFrameTime =
+      std::chrono::steady_clock::now();
+
+  // frame limiter deadline and averaged solver to submit time in ms
+  std::chrono::steady_clock::time_point _frameDeadline;
+  float _workTimeAvg = 0.f;
+
+  WaveFrameStats _stats;
+
 public:
   virtual void cleanup();
 
@@ -154,10 +222,31 @@ public:
 
   virtual void initComputeResources() = 0;
 
+  // currentImage of solver and compute hooks is a resource ring slot
   virtual void updateSolver(uint32_t currentImage) = 0;
 
   virtual bool useExternalMemoryType() = 0;
 
+  // usage of displacement/normal map textures, compute backends add storage
+  virtual VkImageUsageFlags textureImageUsage() {
+    return VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  }
+
+  // commands submitted ahead of rendering in the same queue submission
+  virtual VkCommandBuffer computeCommandBuffer(uint32_t currentImage) {
+    return VK_NULL_HANDLE;
+  }
+
+  // interop textures, uniforms and descriptor sets are allocated per slot of
+  // a ring swapchain images are mapped onto, independent of image count
+  size_t slotCount() const { return _opts.sim_buffers; }
+
+  // index of cascade texture within textureImages, cascade 0 occupies the
+  // first slot count entries
+  size_t cascadeImage(size_t currentImage, size_t cascade) const {
+    return cascade * slotCount() + currentImage;
+  }
+
 protected:
   void initVulkan(GLFWwindow *window);
 
@@ -172,12 +261,22 @@ protected:
 
   void createLogicalDevice();
 
+  void createPipelineCache();
+
+  void savePipelineCache();
+
   void createSwapChain();
 
   void createImageViews();
 
   void createRenderPass();
 
+  void createSceneTarget();
+
+  void cleanupSwapChain();
+
+  void recreateSwapChain();
+
   void createUniformBuffer();
 
   void createDescriptorSetLayout();
@@ -188,10 +287,22 @@ protected:
 
   void createCommandPool();
 
+  void createTimestampPool();
+
+  // false until render pass time of the slot's last frame is available
+  bool readTimestamps(size_t slot, float &gpuTime);
+
+  void createClipmapMesh();
+
   void createVertexBuffers();
 
   void createIndexBuffers();
 
+  void createIndirectBuffers();
+
+  void cullTiles(uint32_t currentImage, const glm::mat4 &view_proj,
+                 const glm::vec2 &offset);
+
   void createTextureImages();
 
   void createTextureImageViews();
@@ -203,7 +314,8 @@ protected:
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
 
   VkImageView createImageView(VkImage image, VkFormat format,
-                              VkImageAspectFlags aspectFlags);
+                              VkImageAspectFlags aspectFlags,
+                              uint32_t mipLevels = 1);
 
   void createShareableImage(uint32_t width, uint32_t height, VkFormat format,
                             VkImageTiling tiling, VkImageUsageFlags usage,
@@ -214,7 +326,7 @@ protected:
   void createImage(uint32_t width, uint32_t height, VkFormat format,
                    VkImageTiling tiling, VkImageUsageFlags usage,
                    VkMemoryPropertyFlags properties, VkImage &image,
-                   VkDeviceMemory &imageMemory);
+                   VkDeviceMemory &imageMemory, uint32_t mipLevels = 1);
 
   VkFormat findSupportedFormat(const std::vector<VkFormat> &candidates,
                                VkImageTiling tiling,
@@ -233,6 +345,8 @@ protected:
   void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
                          uint32_t height);
 
+  void recordMipChain(VkCommandBuffer commandBuffer, VkImage src, VkImage dst);
+
   void transitionUniformLayout(VkBuffer buffer, VkAccessFlagBits src,
                                VkAccessFlagBits dst);
 
@@ -253,6 +367,19 @@ protected:
 
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 
+  void createCommandBuffers();
+
+  void recordCommandBuffer(size_t slot, size_t image, PipelineVariant variant);
+
+  void recordUpscale(VkCommandBuffer commandBuffer, size_t currentImage,
+                     VkExtent2D extent);
+
+  VkExtent2D renderExtent() const;
+
+  void updateRenderScale(float renderTime);
+
+  void paceFrame();
+
   void createSyncObjects();
 
   void updateUniforms(uint32_t currentImage);
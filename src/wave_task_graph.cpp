@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "wave_task_graph.hpp"
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveTaskGraph::depend(const cl::Event & ev)
+{
+    if (ev() == nullptr)
+        return;
+
+    auto found = std::find_if(wait_list.begin(), wait_list.end(),
+                              [&](const cl::Event & e) { return e() == ev(); });
+    if (found == wait_list.end())
+        wait_list.push_back(ev);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveTaskGraph::submit(const Deps & reads, const Deps & writes, const Enqueue & enqueue)
+{
+    wait_list.clear();
+
+    // read after write
+    for (auto obj : reads)
+        depend(accesses[(*obj)()].writer);
+
+    // write after write and write after read
+    for (auto obj : writes)
+    {
+        Access & access = accesses[(*obj)()];
+        depend(access.writer);
+        for (auto & ev : access.readers)
+            depend(ev);
+    }
+
+    cl::Event done;
+    enqueue(wait_list.empty() ? nullptr : &wait_list, &done);
+
+    for (auto obj : reads)
+        accesses[(*obj)()].readers.push_back(done);
+
+    for (auto obj : writes)
+    {
+        Access & access = accesses[(*obj)()];
+        access.writer = done;
+        access.readers.clear();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveTaskGraph::kernel(cl::CommandQueue & queue, const cl::Kernel & kernel,
+                           const cl::NDRange & global, const cl::NDRange & local,
+                           const Deps & reads, const Deps & writes)
+{
+    submit(reads, writes,
+           [&](const std::vector<cl::Event> * wait, cl::Event * done) {
+               queue.enqueueNDRangeKernel(kernel, cl::NullRange, global, local,
+                                          wait, done);
+           });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveTaskGraph::wait(const Deps & objs)
+{
+    wait_list.clear();
+    for (auto obj : objs)
+    {
+        Access & access = accesses[(*obj)()];
+        depend(access.writer);
+        for (auto & ev : access.readers)
+            depend(ev);
+    }
+
+    if (!wait_list.empty())
+        cl::Event::waitForEvents(wait_list);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveTaskGraph::reset()
+{
+    for (auto & entry : accesses)
+    {
+        entry.second.writer = cl::Event();
+        entry.second.readers.clear();
+    }
+    wait_list.clear();
+}
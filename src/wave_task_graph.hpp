@@ -0,0 +1,71 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _WAVE_TASK_GRAPH_HPP_
+#define _WAVE_TASK_GRAPH_HPP_
+
+#include "wave_util.hpp"
+
+#include <functional>
+#include <unordered_map>
+
+// Tracks the last writer and pending readers of OpenCL memory objects, each
+// submitted stage waits only on commands producing or consuming its data so
+// independent stages overlap on out-of-order queues. All queues feeding one
+// graph have to share its context.
+class WaveTaskGraph {
+
+public:
+
+    using Deps = std::vector<const cl::Memory *>;
+    using Enqueue = std::function<void(const std::vector<cl::Event> *, cl::Event *)>;
+
+    // enqueue a stage reading and writing given objects
+    void submit(const Deps & reads, const Deps & writes, const Enqueue & enqueue);
+
+    // shortcut for ND-range kernel stages
+    void kernel(cl::CommandQueue & queue, const cl::Kernel & kernel,
+                const cl::NDRange & global, const cl::NDRange & local,
+                const Deps & reads, const Deps & writes);
+
+    // host wait for all pending accesses of given objects
+    void wait(const Deps & objs);
+
+    // forget tracked accesses, storage is kept for the next frame
+    void reset();
+
+private:
+
+    struct Access {
+        cl::Event writer;
+        std::vector<cl::Event> readers;
+    };
+
+    void depend(const cl::Event & ev);
+
+    std::unordered_map<cl_mem, Access> accesses;
+
+    std::vector<cl::Event> wait_list;
+};
+
+#endif //_WAVE_TASK_GRAPH_HPP_
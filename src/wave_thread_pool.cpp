@@ -0,0 +1,108 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "wave_thread_pool.hpp"
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+
+WaveThreadPool::WaveThreadPool(size_t threads)
+{
+    // hardware_concurrency may report 0 if unknown
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 1; i < threads; i++)
+        workers.emplace_back(&WaveThreadPool::worker, this, i);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+WaveThreadPool::~WaveThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    start_cv.notify_all();
+
+    for (auto & thread : workers)
+        thread.join();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveThreadPool::runSlice(size_t slice)
+{
+    size_t begin = count * slice / size();
+    size_t end = count * (slice + 1) / size();
+    if (begin < end)
+        (*task)(begin, end);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveThreadPool::parallelFor(size_t range, const Task & func)
+{
+    if (workers.empty())
+    {
+        func(0, range);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &func;
+        count = range;
+        pending = workers.size();
+        generation++;
+    }
+    start_cv.notify_all();
+
+    runSlice(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this] { return pending == 0; });
+    task = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveThreadPool::worker(size_t slice)
+{
+    size_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        start_cv.wait(lock, [&] { return stop || generation != seen; });
+        if (stop)
+            return;
+        seen = generation;
+
+        lock.unlock();
+        runSlice(slice);
+        lock.lock();
+
+        if (--pending == 0)
+            done_cv.notify_one();
+    }
+}
@@ -0,0 +1,70 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _WAVE_THREAD_POOL_HPP_
+#define _WAVE_THREAD_POOL_HPP_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads splitting index ranges into contiguous slices,
+// the calling thread processes the first slice itself.
+class WaveThreadPool {
+
+public:
+
+    using Task = std::function<void(size_t begin, size_t end)>;
+
+    explicit WaveThreadPool(size_t threads = std::thread::hardware_concurrency());
+
+    ~WaveThreadPool();
+
+    // number of slices each range is split into
+    size_t size() const { return workers.size() + 1; }
+
+    // run task over [0, count) and wait for all slices to finish
+    void parallelFor(size_t count, const Task & task);
+
+private:
+
+    void worker(size_t slice);
+
+    void runSlice(size_t slice);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+
+    const Task * task = nullptr;
+    size_t count = 0;
+    size_t generation = 0;
+    size_t pending = 0;
+    bool stop = false;
+};
+
+#endif //_WAVE_THREAD_POOL_HPP_
@@ -39,7 +39,10 @@ SOFTWARE.
 #define VK_USE_PLATFORM_WIN32_KHR
 #endif
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <limits>
 #include <sstream>
 #include <vector>
 
@@ -51,6 +54,19 @@ const float DRAG_SPEED_FAC = 0.2f;
 const float ROLL_SPEED_FAC = 8.f;
 const int MAX_FRAMES_IN_FLIGHT = 2;
 
+// ocean spectrum cascades sampled together by ocean shaders, descriptor
+// arrays use this size, keep in sync with MAX_CASCADES of shaders/ocean.*
+const size_t MAX_CASCADES = 4;
+const size_t MAX_CLIPMAP_LEVELS = 8;
+// regular mesh cells spanned by a patch side in tessellation mode
+const int TESS_PATCH_CELLS = 8;
+// granularity of dynamic render resolution changes
+const float RENDER_SCALE_STEP = 0.125f;
+// side of the last reduce_ranges level, each of its RGBA texels holds height
+// range and largest horizontal displacement of every other texel
+const size_t RANGE_LEVEL_SIZE = 2;
+const size_t RANGE_LEVEL_FLOATS = 4 * RANGE_LEVEL_SIZE * RANGE_LEVEL_SIZE;
+
 static const char *IGetErrorString(int clErrorCode) {
   switch (clErrorCode) {
   case CL_SUCCESS:
@@ -296,6 +312,27 @@ struct UniformBufferObject {
   alignas(4) std::float_t z_range_max = 2.f;
   alignas(4) std::float_t choppiness = 1.f;
   alignas(4) std::float_t alt_scale = 1.f;
+  // texture coordinate multiplier of each cascade
+  alignas(16) glm::vec4 cascade_scale = glm::vec4(1.f);
+  alignas(4) std::int32_t cascade_count = 1;
+  // camera snapped translation of the clipmap mesh, world and texture units
+  alignas(8) glm::vec2 grid_offset = glm::vec2(0.f);
+  alignas(8) glm::vec2 grid_tex_offset = glm::vec2(0.f);
+};
+
+// clipmap parameters of vertex pulling mode
+struct MeshPushConstants {
+  alignas(4) std::float_t spacing;
+  alignas(4) std::float_t inv_patch;
+  alignas(4) std::int32_t tile_cells;
+};
+
+// tessellation control parameters
+struct TessPushConstants {
+  alignas(8) glm::vec2 viewport;
+  alignas(4) std::float_t edge_pixels;
+  alignas(4) std::float_t max_level;
+  alignas(4) std::float_t curvature_scale;
 };
 
 struct Vertex {
@@ -351,12 +388,19 @@ struct CliOptions {
   unsigned short technique = 0;
   unsigned short foam_technique = 0;
 
-  bool immediate = false;
+  // simulation backend (0 - OpenCL, 1 - Vulkan compute, 2 - CPU)
+  unsigned short compute_backend = 0;
+
+  // swapchain present mode (0 - FIFO, 1 - mailbox, 2 - immediate)
+  unsigned short present_mode = 1;
 
   bool linearImages = false;
   bool deviceLocalImages = true;
 
   bool useExternalMemory = true;
+
+  // record OpenCL pipeline once per swapchain image (cl_khr_command_buffer)
+  bool commandBuffers = false;
 };
 
 struct SharedOptions : public CliOptions {
@@ -374,6 +418,44 @@ struct SharedOptions : public CliOptions {
   // mesh patch spacing
   float mesh_spacing = 2.f;
 
+  // number of LOD rings around the full resolution block, each doubles
+  // spacing of the previous one
+  size_t clipmap_levels = 4;
+
+  // derive clipmap vertices from gl_VertexIndex instead of vertex buffer
+  bool vertex_pulling = false;
+
+  // draw coarse patch clipmap refined by tessellation shaders
+  bool tessellation = false;
+
+  // target screen space length of tessellated edges in pixels
+  float tess_edge_pixels = 12.f;
+
+  // maximal anisotropy of ocean texture samplers, 0 disables mip chains
+  float anisotropy = 0.f;
+
+  // file persisting compiled Vulkan pipelines between runs, empty disables
+  std::string pipeline_cache = "pipeline_cache.bin";
+
+  // scene render pass GPU time target in ms of dynamic render resolution,
+  // frame interval without timestamp support, 0 disables scaling
+  float frame_budget = 0.f;
+
+  // lowest render resolution relative to the window
+  float min_render_scale = 0.5f;
+
+  // depth of the interop resource ring swapchain images are mapped onto
+  size_t sim_buffers = MAX_FRAMES_IN_FLIGHT;
+
+  // frame rate cap, 0 - unlimited
+  float max_fps = 0.f;
+
+  // start frame work as late as the frame deadline allows
+  bool frame_pacing = false;
+
+  // per-frame timings streamed as CSV, empty - disabled
+  std::string stats_csv;
+
   bool animate = true;
 
   bool show_fps = true;
@@ -381,8 +463,50 @@ struct SharedOptions : public CliOptions {
   // foam simulation range multiplier
   unsigned short foam_size_mult = 2;
 
+  // number of pressure solver relaxation sweeps per CFD step
+  unsigned short jacobi_iterations = 20;
+
+  // fuse divergence with first Jacobi sweep and last sweep with gradient
+  bool cfd_fused_kernels = false;
+
+  // Jacobi sweeps per launch of temporally blocked kernel (1 - disabled)
+  unsigned short jacobi_block_steps = 1;
+
+  // run CFD solver on its own in-order command queue
+  bool cfd_queue = false;
+
+  // device running CFD solver (-1 - the ocean device)
+  int cfd_dev_index = -1;
+
+  // fixed CFD update rate in Hz (0 - one step per rendered frame)
+  float cfd_rate = 0.f;
+
+  // maximal number of CFD substeps caught up in a single frame
+  unsigned short cfd_max_substeps = 4;
+
+  // keep CFL time step on device instead of reading back velocity maximum
+  bool cfd_device_dt = false;
+
+  // CFD advection scheme: 0 - semi-Lagrangian, 1 - MacCormack with limiter
+  unsigned short cfd_advection = 0;
+
+  // number of FFT cascades, each covers a shorter patch and higher band
+  size_t cascades = 1;
+
+  // patch length ratio of consecutive cascades
+  float cascade_ratio = 4.f;
+
+  // dispatch CFD stages only over tiles carrying foam or velocity
+  bool cfd_active_tiles = false;
+
+  // minimal density/velocity magnitude which keeps a tile active
+  float cfd_tile_threshold = 1e-3f;
+
   // ocean parameters changed - rebuild initial spectrum resources
   bool changed = true;
+
+  // window framebuffer changed size - recreate swapchain
+  bool resized = false;
   bool twiddle_factors_init = true;
 
   // ocean in-factors
@@ -400,4 +524,58 @@ struct SharedOptions : public CliOptions {
   bool wireframe_mode = false;
 };
 
+// patch length of a cascade, rounded since kernels take integer sizes
+static int cascade_patch_size(const SharedOptions &opts, size_t cascade) {
+  float size = opts.ocean_grid_size * opts.mesh_spacing /
+               std::pow(opts.cascade_ratio, (float)cascade);
+  return std::max(1, (int)std::lround(size));
+}
+
+// wave number band of a cascade, each boundary lies a few fundamental
+// frequencies above the lowest wave number of the next, shorter cascade
+static glm::vec2 cascade_band(const SharedOptions &opts, size_t cascade) {
+  const float two_pi = 6.28318530718f;
+  const float cutoff = 6.f;
+
+  glm::vec2 band(0.f, std::numeric_limits<float>::max());
+  if (cascade > 0)
+    band.x = two_pi * cutoff / cascade_patch_size(opts, cascade);
+  if (cascade + 1 < opts.cascades)
+    band.y = two_pi * cutoff / cascade_patch_size(opts, cascade + 1);
+  return band;
+}
+
+// largest height and horizontal displacement held by the last reduce_ranges
+// level of a cascade
+static glm::vec2 range_level_bound(const float *level) {
+  glm::vec2 bound(0.f);
+  for (size_t i = 0; i < RANGE_LEVEL_FLOATS; i += 4) {
+    bound.x = std::max(bound.x,
+                       std::max(std::abs(level[i]), std::abs(level[i + 1])));
+    bound.y = std::max(bound.y, level[i + 2]);
+  }
+  return bound;
+}
+
+// regular mesh cells spanned by a clipmap cell, tessellation mode draws
+// coarser patches and refines them on the GPU
+static int clipmap_cell_size(const SharedOptions &opts) {
+  return opts.tessellation ? TESS_PATCH_CELLS : 1;
+}
+
+// cells per side of the full resolution clipmap block, shrinks with number of
+// rings so total cell count stays close to the ocean_grid_size^2 grid
+static int clipmap_block_size(const SharedOptions &opts) {
+  float cells =
+      opts.ocean_grid_size / std::sqrt(1.f + 0.75f * opts.clipmap_levels);
+  int align = 4 * clipmap_cell_size(opts);
+  return std::max(align, (int)(cells / align) * align);
+}
+
+// half width of the whole clipmap mesh in world units
+static float clipmap_half_extent(const SharedOptions &opts) {
+  return 0.5f * clipmap_block_size(opts) * (1 << opts.clipmap_levels) *
+         opts.mesh_spacing;
+}
+
 #endif // OCEANCLVK_UTIL_HPP
@@ -0,0 +1,831 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "wave_vulkan_compute_layer.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <random>
+
+#include <glm/gtc/constants.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+void WaveVulkanComputeLayer::initCompute() {
+  // textures are written by compute shaders of the same device, no interop
+  _opts.useExternalMemory = false;
+
+  // storage access of RGBA32F images is only guaranteed for optimal tiling
+  _opts.linearImages = false;
+
+  if (_opts.technique == 0) {
+    _opts.alt_scale /= 2;
+  }
+
+  log_2_N = (size_t)((log((float)_opts.ocean_tex_size) / log(2.f)) - 1);
+
+  printf("Running simulation on Vulkan compute.\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+VkImageUsageFlags WaveVulkanComputeLayer::textureImageUsage() {
+  return WaveVulkanLayer::textureImageUsage() | VK_IMAGE_USAGE_STORAGE_BIT;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool WaveVulkanComputeLayer::useExternalMemoryType() { return false; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanComputeLayer::createComputeImage(uint32_t width,
+                                                uint32_t height,
+                                                ComputeImage &img) {
+  createImage(width, height, VK_FORMAT_R32G32B32A32_SFLOAT,
+              VK_IMAGE_TILING_OPTIMAL,
+              VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                  VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, img.image, img.memory);
+  img.view = createImageView(img.image, VK_FORMAT_R32G32B32A32_SFLOAT,
+                             VK_IMAGE_ASPECT_COLOR_BIT);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanComputeLayer::destroyComputeImage(ComputeImage &img) {
+  vkDestroyImageView(_vulkan.device, img.view, nullptr);
+  vkDestroyImage(_vulkan.device, img.image, nullptr);
+  vkFreeMemory(_vulkan.device, img.memory, nullptr);
+  img = ComputeImage{};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void imageBarrier(VkImage image, VkImageLayout oldLayout,
+                         VkImageLayout newLayout, VkAccessFlags srcAccess,
+                         VkAccessFlags dstAccess,
+                         VkImageMemoryBarrier &barrier) {
+  barrier = VkImageMemoryBarrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = oldLayout;
+  barrier.newLayout = newLayout;
+  barrier.srcAccessMask = srcAccess;
+  barrier.dstAccessMask = dstAccess;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanComputeLayer::uploadComputeImage(const void *data,
+                                                uint32_t width,
+                                                uint32_t height,
+                                                ComputeImage &img) {
+  VkDeviceSize imageSize = width * height * 4 * sizeof(float);
+
+  void *mapped;
+  vkMapMemory(_vulkan.device, _vulkan.stagingBufferMemory, 0, imageSize, 0,
+              &mapped);
+  memcpy(mapped, data, static_cast<size_t>(imageSize));
+  vkUnmapMemory(_vulkan.device, _vulkan.stagingBufferMemory);
+
+  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+  VkImageMemoryBarrier barrier;
+  imageBarrier(img.image, VK_IMAGE_LAYOUT_UNDEFINED,
+               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+               VK_ACCESS_TRANSFER_WRITE_BIT, barrier);
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+
+  VkBufferImageCopy region{};
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.layerCount = 1;
+  region.imageExtent = {width, height, 1};
+  vkCmdCopyBufferToImage(commandBuffer, _vulkan.stagingBuffer, img.image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+  imageBarrier(img.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+               VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_TRANSFER_WRITE_BIT,
+               VK_ACCESS_SHADER_READ_BIT, barrier);
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+
+  endSingleTimeCommands(commandBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanComputeLayer::createComputePipelines() {
+  std::array<VkDescriptorSetLayoutBinding, COMPUTE_IMAGE_BINDINGS + 1>
+      bindings{};
+  for (uint32_t i = 0; i < bindings.size(); i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorCount = 1;
+    bindings[i].descriptorType = i < COMPUTE_IMAGE_BINDINGS
+                                     ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                                     : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+  layoutInfo.pBindings = bindings.data();
+
+  if (vkCreateDescriptorSetLayout(_vulkan.device, &layoutInfo, nullptr,
+                                  &computeSetLayout) != VK_SUCCESS)
+    throw std::runtime_error("WaveVulkanComputeLayer::createComputePipelines: "
+                             "failed to create descriptor set layout!");
+
+  VkPushConstantRange pushRange{};
+  pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushRange.offset = 0;
+  pushRange.size = sizeof(PushData);
+
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.setLayoutCount = 1;
+  pipelineLayoutInfo.pSetLayouts = &computeSetLayout;
+  pipelineLayoutInfo.pushConstantRangeCount = 1;
+  pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+
+  if (vkCreatePipelineLayout(_vulkan.device, &pipelineLayoutInfo, nullptr,
+                             &computePipelineLayout) != VK_SUCCESS)
+    throw std::runtime_error("WaveVulkanComputeLayer::createComputePipelines: "
+                             "failed to create pipeline layout!");
+
+  const char *shaders[CS_COUNT] = {
+      _opts.technique == 0 ? "shaders/init_spectrum_phillips.comp.spv"
+                           : "shaders/init_spectrum_jonswap.comp.spv",
+      "shaders/time_spectrum.comp.spv",
+      "shaders/fft.comp.spv",
+      "shaders/inversion.comp.spv",
+      "shaders/reduce_ranges.comp.spv",
+      "shaders/normals.comp.spv",
+      "shaders/foam.comp.spv"};
+
+  for (size_t stage = 0; stage < CS_COUNT; stage++) {
+    VkShaderModule shaderModule = createShaderModule(readFile(shaders[stage]));
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = computePipelineLayout;
+
+    if (vkCreateComputePipelines(_vulkan.device, _vulkan.pipelineCache, 1,
+                                 &pipelineInfo, nullptr,
+                                 &computePipelines[stage]) != VK_SUCCESS)
+      throw std::runtime_error("WaveVulkanComputeLayer::createComputePipelines:"
+                               " failed to create compute pipeline!");
+
+    vkDestroyShaderModule(_vulkan.device, shaderModule, nullptr);
+  }
+
+  // one set per recorded dispatch: time spectrum, 2 FFT directions of 3
+  // components, inversion, reduction pyramid, normals and foam
+  uint32_t setsPerImage = static_cast<uint32_t>(1 + 6 * log_2_N + 1 + log_2_N +
+                                                1 + 1);
+  uint32_t maxSets =
+      setsPerImage * static_cast<uint32_t>(slotCount()) + 1;
+
+  std::array<VkDescriptorPoolSize, 2> poolSizes{};
+  poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  poolSizes[0].descriptorCount = maxSets * COMPUTE_IMAGE_BINDINGS;
+  poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  poolSizes[1].descriptorCount = maxSets;
+
+  VkDescriptorPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+  poolInfo.pPoolSizes = poolSizes.data();
+  poolInfo.maxSets = maxSets;
+
+  if (vkCreateDescriptorPool(_vulkan.device, &poolInfo, nullptr,
+                             &computeDescriptorPool) != VK_SUCCESS)
+    throw std::runtime_error("WaveVulkanComputeLayer::createComputePipelines: "
+                             "failed to create descriptor pool!");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+VkDescriptorSet
+WaveVulkanComputeLayer::createComputeSet(const ComputeViews &views,
+                                         VkBuffer frameBuffer) {
+  VkDescriptorSetAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.descriptorPool = computeDescriptorPool;
+  allocInfo.descriptorSetCount = 1;
+  allocInfo.pSetLayouts = &computeSetLayout;
+
+  VkDescriptorSet set;
+  if (vkAllocateDescriptorSets(_vulkan.device, &allocInfo, &set) != VK_SUCCESS)
+    throw std::runtime_error("WaveVulkanComputeLayer::createComputeSet: failed "
+                             "to allocate descriptor set!");
+
+  // bindings not used by a shader stay unwritten
+  std::array<VkDescriptorImageInfo, COMPUTE_IMAGE_BINDINGS> imageInfo{};
+  std::vector<VkWriteDescriptorSet> descriptorWrites;
+
+  for (uint32_t i = 0; i < COMPUTE_IMAGE_BINDINGS; i++) {
+    if (views[i] == VK_NULL_HANDLE)
+      continue;
+
+    imageInfo[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    imageInfo[i].imageView = views[i];
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = i;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    write.descriptorCount = 1;
+    write.pImageInfo = &imageInfo[i];
+    descriptorWrites.push_back(write);
+  }
+
+  VkDescriptorBufferInfo bufferInfo{};
+  if (frameBuffer != VK_NULL_HANDLE) {
+    bufferInfo.buffer = frameBuffer;
+    bufferInfo.offset = 0;
+    bufferInfo.range = sizeof(FrameData);
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = COMPUTE_IMAGE_BINDINGS;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.descriptorCount = 1;
+    write.pBufferInfo = &bufferInfo;
+    descriptorWrites.push_back(write);
+  }
+
+  vkUpdateDescriptorSets(_vulkan.device,
+                         static_cast<uint32_t>(descriptorWrites.size()),
+                         descriptorWrites.data(), 0, nullptr);
+  return set;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanComputeLayer::initComputeResources() {
+  QueueFamilyIndices indices = findQueueFamilies(_vulkan.physicalDevice);
+
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(_vulkan.physicalDevice,
+                                           &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(
+      _vulkan.physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+  if (!(queueFamilies[indices.graphicsFamily].queueFlags &
+        VK_QUEUE_COMPUTE_BIT))
+    throw std::runtime_error("WaveVulkanComputeLayer::initComputeResources: "
+                             "graphics queue without compute support!");
+
+  createComputePipelines();
+
+  uint32_t texSize = static_cast<uint32_t>(_opts.ocean_tex_size);
+
+  createComputeImage(texSize, texSize, noise_img);
+  createComputeImage(texSize, texSize, h0k_img);
+  createComputeImage(static_cast<uint32_t>(log_2_N), texSize, twiddle_img);
+  for (auto &img : dxyz_coef_img)
+    createComputeImage(texSize, texSize, img);
+  createComputeImage(texSize, texSize, hkt_pong_img);
+  createComputeImage(texSize, texSize, z_ranges_img[0]);
+  createComputeImage(texSize / 2, texSize / 2, z_ranges_img[1]);
+
+  {
+    std::vector<glm::vec4> phase_array(_opts.ocean_tex_size *
+                                       _opts.ocean_tex_size);
+    std::random_device dev;
+    std::mt19937 rng(dev());
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+
+    for (size_t i = 0; i < phase_array.size(); ++i)
+      phase_array[i] = {dist(rng), dist(rng), dist(rng), dist(rng)};
+
+    uploadComputeImage(phase_array.data(), texSize, texSize, noise_img);
+  }
+
+  // remaining storages live in general layout, display textures start
+  // cleared since foam factor accumulates in normal map
+  {
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+    std::vector<VkImageMemoryBarrier> barriers;
+    VkImageMemoryBarrier barrier;
+    for (auto img : {&h0k_img, &dxyz_coef_img[0], &dxyz_coef_img[1],
+                     &dxyz_coef_img[2], &hkt_pong_img, &z_ranges_img[0],
+                     &z_ranges_img[1]}) {
+      imageBarrier(img->image, VK_IMAGE_LAYOUT_UNDEFINED,
+                   VK_IMAGE_LAYOUT_GENERAL, 0,
+                   VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                   barrier);
+      barriers.push_back(barrier);
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                         nullptr, static_cast<uint32_t>(barriers.size()),
+                         barriers.data());
+
+    barriers.clear();
+    for (size_t target = 0; target < IOPT_COUNT; target++) {
+      for (auto image : _vulkan.textureImages[target].images) {
+        imageBarrier(image, VK_IMAGE_LAYOUT_UNDEFINED,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+                     VK_ACCESS_TRANSFER_WRITE_BIT, barrier);
+        barriers.push_back(barrier);
+      }
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, static_cast<uint32_t>(barriers.size()),
+                         barriers.data());
+
+    VkClearColorValue clearColor{};
+    VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    barriers.clear();
+    for (size_t target = 0; target < IOPT_COUNT; target++) {
+      for (auto image : _vulkan.textureImages[target].images) {
+        vkCmdClearColorImage(commandBuffer, image,
+                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor,
+                             1, &range);
+        imageBarrier(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                     VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                     barrier);
+        barriers.push_back(barrier);
+      }
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                             VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr,
+                         static_cast<uint32_t>(barriers.size()),
+                         barriers.data());
+
+    endSingleTimeCommands(commandBuffer);
+  }
+
+  size_t imageCount = slotCount();
+
+  frameBuffers.resize(imageCount);
+  frameBufferMemories.resize(imageCount);
+  frameData.resize(imageCount);
+  for (size_t i = 0; i < imageCount; i++) {
+    createBuffer(sizeof(FrameData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                 frameBuffers[i], frameBufferMemories[i]);
+    vkMapMemory(_vulkan.device, frameBufferMemories[i], 0, sizeof(FrameData), 0,
+                reinterpret_cast<void **>(&frameData[i]));
+    frameData[i]->elapsed = 0.f;
+  }
+
+  // RGBA32F texels of the last reduction level per slot
+  zRangeBuffers.resize(imageCount);
+  zRangeBufferMemories.resize(imageCount);
+  zRangeData.resize(imageCount);
+  for (size_t i = 0; i < imageCount; i++) {
+    createBuffer(RANGE_LEVEL_FLOATS * sizeof(float),
+                 VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                 zRangeBuffers[i], zRangeBufferMemories[i]);
+    vkMapMemory(_vulkan.device, zRangeBufferMemories[i], 0,
+                RANGE_LEVEL_FLOATS * sizeof(float), 0,
+                reinterpret_cast<void **>(&zRangeData[i]));
+    std::fill(zRangeData[i], zRangeData[i] + RANGE_LEVEL_FLOATS, 0.f);
+    zRangeData[i][1] = 2.f;
+  }
+
+  init_spectrum_set =
+      createComputeSet({noise_img.view, VK_NULL_HANDLE, VK_NULL_HANDLE,
+                        h0k_img.view, VK_NULL_HANDLE, VK_NULL_HANDLE});
+
+  VkCommandBufferAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.commandPool = _vulkan.commandPool;
+  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandBufferCount = static_cast<uint32_t>(imageCount);
+
+  computeCommandBuffers.resize(imageCount);
+  if (vkAllocateCommandBuffers(_vulkan.device, &allocInfo,
+                               computeCommandBuffers.data()) != VK_SUCCESS)
+    throw std::runtime_error("WaveVulkanComputeLayer::initComputeResources: "
+                             "failed to allocate command buffers!");
+
+  for (uint32_t i = 0; i < imageCount; i++)
+    recordComputeCommands(i);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanComputeLayer::initTwiddleFactors() {
+  int resolution = static_cast<int>(_opts.ocean_tex_size);
+  int stages = static_cast<int>(log_2_N);
+
+  std::vector<int> bit_reversed(resolution);
+  for (int i = 0; i < resolution; i++)
+    bit_reversed[i] = reverse_bits(i, stages);
+
+  // same butterfly layout as twiddle.cl, x - stage, y - element
+  std::vector<glm::vec4> twiddle(stages * resolution);
+  for (int y = 0; y < resolution; y++) {
+    for (int x = 0; x < stages; x++) {
+      float k = fmod(y * ((float)resolution / pow(2.f, (float)(x + 1))),
+                     (float)resolution);
+      float angle = 2.f * glm::pi<float>() * k / (float)resolution;
+
+      int butterflyspan = (int)pow(2.f, (float)x);
+      bool top_wing =
+          fmod((float)y, pow(2.f, (float)(x + 1))) < pow(2.f, (float)x);
+
+      glm::vec2 inds;
+      if (x == 0)
+        inds = top_wing ? glm::vec2(bit_reversed[y], bit_reversed[y + 1])
+                        : glm::vec2(bit_reversed[y - 1], bit_reversed[y]);
+      else
+        inds = top_wing ? glm::vec2(y, y + butterflyspan)
+                        : glm::vec2(y - butterflyspan, y);
+
+      twiddle[y * stages + x] =
+          glm::vec4(glm::cos(angle), glm::sin(angle), inds.x, inds.y);
+    }
+  }
+
+  uploadComputeImage(twiddle.data(), static_cast<uint32_t>(stages),
+                     static_cast<uint32_t>(resolution), twiddle_img);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanComputeLayer::initSpectrum() {
+  float wind_angle_rad = glm::radians(_opts.wind_angle);
+
+  PushData push{};
+  push.info = glm::ivec4((int)(_opts.ocean_grid_size * _opts.mesh_spacing),
+                         (int)_opts.ocean_tex_size, 0, 0);
+  push.params = glm::vec4(_opts.wind_magnitude * glm::cos(wind_angle_rad),
+                          _opts.wind_magnitude * glm::sin(wind_angle_rad),
+                          _opts.amplitude, _opts.supress_factor);
+
+  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+  // frames in flight may still read previous spectrum
+  computeBarrier(commandBuffer);
+  dispatch(commandBuffer, CS_INIT_SPECTRUM, init_spectrum_set, push,
+           static_cast<uint32_t>(_opts.ocean_tex_size),
+           static_cast<uint32_t>(_opts.ocean_tex_size));
+  computeBarrier(commandBuffer);
+
+  endSingleTimeCommands(commandBuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanComputeLayer::dispatch(VkCommandBuffer commandBuffer,
+                                      ComputeStage stage, VkDescriptorSet set,
+                                      const PushData &push, uint32_t width,
+                                      uint32_t height) {
+  // local size of all compute shaders is 16x16
+  const uint32_t local_size = 16;
+
+  vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    computePipelines[stage]);
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          computePipelineLayout, 0, 1, &set, 0, nullptr);
+  vkCmdPushConstants(commandBuffer, computePipelineLayout,
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushData), &push);
+  vkCmdDispatch(commandBuffer, (width + local_size - 1) / local_size,
+                (height + local_size - 1) / local_size, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanComputeLayer::computeBarrier(VkCommandBuffer commandBuffer) {
+  VkMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanComputeLayer::recordComputeCommands(uint32_t currentImage) {
+  VkCommandBuffer commandBuffer = computeCommandBuffers[currentImage];
+  uint32_t texSize = static_cast<uint32_t>(_opts.ocean_tex_size);
+
+  VkImage displacement =
+      _vulkan.textureImages[IOPT_DISPLACEMENT].images[currentImage];
+  VkImage normal_map =
+      _vulkan.textureImages[IOPT_NORMAL_MAP].images[currentImage];
+  VkImageView displacement_view =
+      _vulkan.textureImages[IOPT_DISPLACEMENT].imageViews[currentImage];
+  VkImageView normal_map_view =
+      _vulkan.textureImages[IOPT_NORMAL_MAP].imageViews[currentImage];
+
+  PushData push{};
+  push.info = glm::ivec4((int)(_opts.ocean_grid_size * _opts.mesh_spacing),
+                         (int)_opts.ocean_tex_size, 0, 0);
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+  if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    throw std::runtime_error("WaveVulkanComputeLayer::recordComputeCommands: "
+                             "failed to begin recording command buffer!");
+
+  // shared storages are reused by consecutive frames, display textures of
+  // this image were sampled by its previous rendering
+  {
+    VkMemoryBarrier memoryBarrier{};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask =
+        VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+                                  VK_ACCESS_SHADER_WRITE_BIT |
+                                  VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    std::array<VkImageMemoryBarrier, IOPT_COUNT> barriers;
+    imageBarrier(displacement, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                 VK_IMAGE_LAYOUT_GENERAL, 0,
+                 VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                 barriers[IOPT_DISPLACEMENT]);
+    imageBarrier(normal_map, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                 VK_IMAGE_LAYOUT_GENERAL, 0,
+                 VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                 barriers[IOPT_NORMAL_MAP]);
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                             VK_PIPELINE_STAGE_TRANSFER_BIT |
+                             VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &memoryBarrier, 0, nullptr,
+                         static_cast<uint32_t>(barriers.size()),
+                         barriers.data());
+  }
+
+  // time dependent spectrum
+  dispatch(commandBuffer, CS_TIME_SPECTRUM,
+           createComputeSet({h0k_img.view, VK_NULL_HANDLE, VK_NULL_HANDLE,
+                             dxyz_coef_img[0].view, dxyz_coef_img[1].view,
+                             dxyz_coef_img[2].view},
+                            frameBuffers[currentImage]),
+           push, texSize, texSize);
+  computeBarrier(commandBuffer);
+
+  // horizontal and vertical 1D FFT passes, even count of passes leaves the
+  // result in the source image so no copy is needed
+  for (int i = 0; i < 3; i++) {
+    VkImageView displ_swap[] = {dxyz_coef_img[i].view, hkt_pong_img.view};
+    bool ifft_pingpong = false;
+
+    for (int dir = 0; dir < 2; dir++) {
+      for (int p = 0; p < log_2_N; p++) {
+        int src = ifft_pingpong ? 1 : 0;
+        push.info.z = dir;
+        push.info.w = p;
+        dispatch(commandBuffer, CS_FFT,
+                 createComputeSet({twiddle_img.view, displ_swap[src],
+                                   VK_NULL_HANDLE, displ_swap[1 - src],
+                                   VK_NULL_HANDLE, VK_NULL_HANDLE}),
+                 push, texSize, texSize);
+        computeBarrier(commandBuffer);
+
+        ifft_pingpong = !ifft_pingpong;
+      }
+    }
+  }
+
+  // inversion
+  push.info.z = push.info.w = 0;
+  dispatch(commandBuffer, CS_INVERSION,
+           createComputeSet({dxyz_coef_img[0].view, dxyz_coef_img[1].view,
+                             dxyz_coef_img[2].view, displacement_view,
+                             z_ranges_img[0].view, VK_NULL_HANDLE}),
+           push, texSize, texSize);
+  computeBarrier(commandBuffer);
+
+  // min max reduction
+  {
+    int level = (int)texSize / 2;
+    for (int p = 0; p < log_2_N; p++) {
+      push.info.z = push.info.w = level;
+      dispatch(commandBuffer, CS_REDUCE_RANGES,
+               createComputeSet({z_ranges_img[p % 2].view, VK_NULL_HANDLE,
+                                 VK_NULL_HANDLE, z_ranges_img[(p + 1) % 2].view,
+                                 VK_NULL_HANDLE, VK_NULL_HANDLE}),
+               push, level, level);
+      computeBarrier(commandBuffer);
+      level /= 2;
+    }
+  }
+  ComputeImage &z_range_level = z_ranges_img[log_2_N % 2];
+
+  // normals computation
+  push.info.z = push.info.w = 0;
+  dispatch(commandBuffer, CS_NORMALS,
+           createComputeSet({displacement_view, VK_NULL_HANDLE, VK_NULL_HANDLE,
+                             normal_map_view, VK_NULL_HANDLE, VK_NULL_HANDLE}),
+           push, texSize, texSize);
+  computeBarrier(commandBuffer);
+
+  // foam computation, z range read on device
+  push.params = glm::vec4(0.f, 0.f, _opts.technique == 0 ? 2.f : 8.f, 0.f);
+  dispatch(commandBuffer, CS_FOAM,
+           createComputeSet({noise_img.view, displacement_view,
+                             z_range_level.view, normal_map_view,
+                             VK_NULL_HANDLE, VK_NULL_HANDLE}),
+           push, texSize, texSize);
+
+  {
+    VkMemoryBarrier memoryBarrier{};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    std::array<VkImageMemoryBarrier, IOPT_COUNT> barriers;
+    imageBarrier(displacement, VK_IMAGE_LAYOUT_GENERAL,
+                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                 VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                 barriers[IOPT_DISPLACEMENT]);
+    imageBarrier(normal_map, VK_IMAGE_LAYOUT_GENERAL,
+                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                 VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                 barriers[IOPT_NORMAL_MAP]);
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT |
+                             VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 1, &memoryBarrier, 0, nullptr,
+                         static_cast<uint32_t>(barriers.size()),
+                         barriers.data());
+  }
+
+  // z range goes straight into uniforms of this frame, no host round trip
+  {
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {RANGE_LEVEL_SIZE, RANGE_LEVEL_SIZE, 1};
+    vkCmdCopyImageToBuffer(commandBuffer, z_range_level.image,
+                           VK_IMAGE_LAYOUT_GENERAL,
+                           zRangeBuffers[currentImage], 1, &region);
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask =
+        VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = zRangeBuffers[currentImage];
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT |
+                             VK_PIPELINE_STAGE_HOST_BIT,
+                         0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = 0;
+    copyRegion.dstOffset = offsetof(UniformBufferObject, z_range_min);
+    copyRegion.size = 2 * sizeof(float);
+    vkCmdCopyBuffer(commandBuffer, zRangeBuffers[currentImage],
+                    _vulkan.uniformBuffers[currentImage], 1, &copyRegion);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_UNIFORM_READ_BIT;
+    barrier.buffer = _vulkan.uniformBuffers[currentImage];
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, nullptr, 1, &barrier, 0, nullptr);
+  }
+
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    throw std::runtime_error("WaveVulkanComputeLayer::recordComputeCommands: "
+                             "failed to record command buffer!");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+VkCommandBuffer
+WaveVulkanComputeLayer::computeCommandBuffer(uint32_t currentImage) {
+  return simulate ? computeCommandBuffers[currentImage] : VK_NULL_HANDLE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanComputeLayer::updateSolver(uint32_t currentImage) {
+  // per slot frame data and uniforms are rewritten below, drawFrame retired
+  // their last use
+
+  // recorded commands overwrite it on device, host copy of the retired frame
+  // serves paused frames and culling
+  z_range = glm::vec2(zRangeData[currentImage][0], zRangeData[currentImage][1]);
+  displ_bound = range_level_bound(zRangeData[currentImage]);
+  updateUniforms(currentImage);
+
+  auto end = std::chrono::system_clock::now();
+
+  simulate = _opts.animate;
+  if (_opts.animate) {
+    std::chrono::duration<float> delta = end - start;
+    elapsed = delta.count();
+
+    if (_opts.twiddle_factors_init) {
+      initTwiddleFactors();
+      _opts.twiddle_factors_init = false;
+    }
+
+    // change of some ocean's parameters requires to rebuild initial spectrum
+    // image
+    if (_opts.changed) {
+      initSpectrum();
+      _opts.changed = false;
+    }
+
+    // the only per-frame input of recorded pipeline
+    frameData[currentImage]->elapsed = elapsed;
+  } else {
+    // hold the animation at the same time point
+    std::chrono::duration<float> duration(elapsed);
+    start = end - std::chrono::duration_cast<std::chrono::seconds>(duration);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void WaveVulkanComputeLayer::cleanup() {
+  for (auto pipeline : computePipelines)
+    vkDestroyPipeline(_vulkan.device, pipeline, nullptr);
+
+  vkDestroyPipelineLayout(_vulkan.device, computePipelineLayout, nullptr);
+  vkDestroyDescriptorPool(_vulkan.device, computeDescriptorPool, nullptr);
+  vkDestroyDescriptorSetLayout(_vulkan.device, computeSetLayout, nullptr);
+
+  for (auto img : {&noise_img, &h0k_img, &twiddle_img, &dxyz_coef_img[0],
+                   &dxyz_coef_img[1], &dxyz_coef_img[2], &hkt_pong_img,
+                   &z_ranges_img[0], &z_ranges_img[1]})
+    destroyComputeImage(*img);
+
+  for (size_t i = 0; i < frameBuffers.size(); i++) {
+    vkDestroyBuffer(_vulkan.device, frameBuffers[i], nullptr);
+    vkFreeMemory(_vulkan.device, frameBufferMemories[i], nullptr);
+  }
+
+  for (size_t i = 0; i < zRangeBuffers.size(); i++) {
+    vkDestroyBuffer(_vulkan.device, zRangeBuffers[i], nullptr);
+    vkFreeMemory(_vulkan.device, zRangeBufferMemories[i], nullptr);
+  }
+
+  // command buffers are released together with the pool
+  WaveVulkanLayer::cleanup();
+}
@@ -0,0 +1,150 @@
+/*
+MIT License
+
+Copyright (c) 2025 Marcin Hajder
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef _WAVE_VULKAN_COMPUTE_LAYER_HPP_
+#define _WAVE_VULKAN_COMPUTE_LAYER_HPP_
+
+#include "wave_util.hpp"
+#include "wave_render_layer.hpp"
+
+// whole simulation in Vulkan compute shaders, results written straight into
+// the sampled textures and submitted together with rendering commands
+class WaveVulkanComputeLayer : public WaveVulkanLayer {
+
+public:
+
+    WaveVulkanComputeLayer(SharedOptions & opts) : WaveVulkanLayer(opts) {}
+
+    virtual void cleanup() override;
+
+    virtual void initCompute() override;
+
+    virtual void initComputeResources() override;
+
+    void updateSolver(uint32_t currentImage) override;
+
+    bool useExternalMemoryType() override;
+
+protected:
+
+    VkImageUsageFlags textureImageUsage() override;
+
+    VkCommandBuffer computeCommandBuffer(uint32_t currentImage) override;
+
+protected:
+
+    enum ComputeStage {
+        CS_INIT_SPECTRUM = 0,
+        CS_TIME_SPECTRUM,
+        CS_FFT,
+        CS_INVERSION,
+        CS_REDUCE_RANGES,
+        CS_NORMALS,
+        CS_FOAM,
+        CS_COUNT
+    };
+
+    // storage image bindings 0-5 and per-image frame data at binding 6
+    static const uint32_t COMPUTE_IMAGE_BINDINGS = 6;
+
+    using ComputeViews = std::array<VkImageView, COMPUTE_IMAGE_BINDINGS>;
+
+    // mirrors push constant block of compute shaders
+    struct PushData {
+        glm::ivec4 info;
+        glm::vec4 params;
+    };
+
+    // mirrors FrameData uniform block of time spectrum shader
+    struct FrameData {
+        alignas(16) float elapsed;
+    };
+
+    struct ComputeImage {
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+    };
+
+    void createComputePipelines();
+
+    void createComputeImage(uint32_t width, uint32_t height, ComputeImage & img);
+
+    void destroyComputeImage(ComputeImage & img);
+
+    void uploadComputeImage(const void * data, uint32_t width, uint32_t height,
+                            ComputeImage & img);
+
+    VkDescriptorSet createComputeSet(const ComputeViews & views,
+                                     VkBuffer frameBuffer = VK_NULL_HANDLE);
+
+    void dispatch(VkCommandBuffer commandBuffer, ComputeStage stage,
+                  VkDescriptorSet set, const PushData & push, uint32_t width,
+                  uint32_t height);
+
+    void computeBarrier(VkCommandBuffer commandBuffer);
+
+    void initTwiddleFactors();
+
+    void initSpectrum();
+
+    void recordComputeCommands(uint32_t currentImage);
+
+protected:
+
+    VkDescriptorSetLayout computeSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout computePipelineLayout = VK_NULL_HANDLE;
+    VkDescriptorPool computeDescriptorPool = VK_NULL_HANDLE;
+    std::array<VkPipeline, CS_COUNT> computePipelines{};
+
+    // FFT intermediate storages, shared by all resource slots
+    ComputeImage noise_img;
+    ComputeImage h0k_img;
+    ComputeImage twiddle_img;
+    ComputeImage dxyz_coef_img[3];
+    ComputeImage hkt_pong_img;
+    ComputeImage z_ranges_img[2];
+
+    VkDescriptorSet init_spectrum_set = VK_NULL_HANDLE;
+
+    // per resource slot elapsed time, persistently mapped
+    std::vector<VkBuffer> frameBuffers;
+    std::vector<VkDeviceMemory> frameBufferMemories;
+    std::vector<FrameData *> frameData;
+
+    // per resource slot z range of its last frame, also source of uniform
+    // buffer update; host reads it only once the slot fence is signaled
+    std::vector<VkBuffer> zRangeBuffers;
+    std::vector<VkDeviceMemory> zRangeBufferMemories;
+    std::vector<float *> zRangeData;
+
+    std::vector<VkCommandBuffer> computeCommandBuffers;
+
+    size_t log_2_N = 0;
+
+    float elapsed = 0.f;
+
+    bool simulate = false;
+};
+
+#endif //_WAVE_VULKAN_COMPUTE_LAYER_HPP_